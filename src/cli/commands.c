@@ -4,35 +4,140 @@
 #include "../core/book.h"
 #include "../core/note.h"
 #include "../utils/error.h"
+#include "../external/pdftext.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
 
 #define VERSION "0.1.0"
+#define IMPORT_BATCH_SIZE 1000
+#define DEFAULT_PAGE_SIZE 50
+#define DEFAULT_SEARCH_LIMIT 20
 
 /* ============================================================================
  * Helper functions
  * ========================================================================= */
 
 static void print_usage(void) {
-    printf("Usage: booknote <command> [options]\n\n");
+    printf("Usage: booknote [--trace-queries] <command> [options]\n\n");
     printf("Commands:\n");
     printf("  add <filepath>           Add a book to your library\n");
-    printf("  list                     List all books\n");
+    printf("  list [--limit N]         List books (--after ID for the next page)\n");
     printf("  show <book-id>           Show book details and notes\n");
     printf("  note <book-id> <text>    Add a note to a book\n");
-    printf("  search <query>           Search notes\n");
+    printf("  search <query>           Search notes and PDF text, best matches first\n");
+    printf("                           (--notes, --substring, --fuzzy, --limit N)\n");
+    printf("  find <text>              Find books by title, author, publisher or ISBN\n");
     printf("  delete <book-id>         Delete a book\n");
+    printf("  reindex [--substring]    Rebuild search indexes (optionally add substring search)\n");
+    printf("  import-notes <file|->    Import notes from NDJSON\n");
+    printf("  index-pdf [book-id]      Extract PDF text so search covers book pages\n");
+    printf("  stats [book-id]          Show library or book statistics (--queries to time them)\n");
+    printf("  backup <path>            Copy the library to a file while it stays in use\n");
+    printf("  restore <path>           Replace the library with a backup\n");
     printf("  help [command]           Show help\n");
     printf("  version                  Show version\n\n");
+    printf("Global options:\n");
+    printf("  --trace-queries          Print per-statement timings and row counts at exit\n\n");
     printf("Examples:\n");
     printf("  booknote add mybook.pdf --title \"My Book\" --author \"Author Name\"\n");
     printf("  booknote list\n");
     printf("  booknote note 1 \"This is an important point\"\n");
-    printf("  booknote search \"machine learning\"\n\n");
+    printf("  booknote search \"machine learning\"\n");
+    printf("  booknote import-notes notes.ndjson\n\n");
     printf("For more information, visit: https://github.com/AldoJimenezW/booknote\n");
 }
 
+static void print_book_line(const Book *book) {
+    printf("[%d] %s", book->id, book->title);
+    if (book->author) {
+        printf(" - %s", book->author);
+    }
+    if (book->year > 0) {
+        printf(" (%d)", book->year);
+    }
+    printf("\n");
+}
+
+static void print_note_line(const Note *note) {
+    printf("[%d] ", note->id);
+    if (note->page_number > 0) {
+        printf("(page %d) ", note->page_number);
+    }
+    printf("%s\n", note->content);
+}
+
+/* Insert one batch of parsed notes and report failed rows */
+static int flush_note_batch(Database *db, Note **batch, const long *lines, BnError *row_errors,
+                            int count, int *imported, int *failed) {
+    int inserted = 0;
+    BnError err = db_note_insert_many(db, batch, count, row_errors, &inserted);
+    
+    for (int i = 0; i < count; i++) {
+        if (err == BN_SUCCESS && row_errors[i] != BN_SUCCESS) {
+            fprintf(stderr, "Line %ld: %s\n", lines[i],
+                    row_errors[i] == BN_ERROR_NOT_FOUND ? "Book not found" : bn_error_string(row_errors[i]));
+        }
+        note_free(batch[i]);
+        batch[i] = NULL;
+    }
+    
+    if (err != BN_SUCCESS) {
+        bn_print_error(err, "importing notes");
+        *failed += count;
+        return -1;
+    }
+    
+    *imported += inserted;
+    *failed += count - inserted;
+    return 0;
+}
+
+static void format_timestamp(long long when, char *buf, size_t size) {
+    time_t t = (time_t)when;
+    struct tm tm;
+    if (when <= 0 || !localtime_r(&t, &tm) || strftime(buf, size, "%Y-%m-%d %H:%M", &tm) == 0) {
+        snprintf(buf, size, "never");
+    }
+}
+
+typedef struct {
+    const char *label;
+    struct timespec start;
+    int last_percent;
+} CopyProgress;
+
+static double seconds_since(const struct timespec *start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static void print_copy_progress(long long done_bytes, long long total_bytes, void *user_data) {
+    CopyProgress *progress = (CopyProgress *)user_data;
+    int percent = total_bytes > 0 ? (int)(done_bytes * 100 / total_bytes) : 100;
+    if (percent == progress->last_percent) {
+        return;
+    }
+    progress->last_percent = percent;
+    
+    printf("\r%s %3d%% (%.1f of %.1f MiB)", progress->label, percent,
+           done_bytes / 1048576.0, total_bytes / 1048576.0);
+    fflush(stdout);
+}
+
+/* Finish the progress line with the overall throughput */
+static void print_copy_summary(const CopyProgress *progress, const char *path) {
+    struct stat st;
+    double mib = stat(path, &st) == 0 ? st.st_size / 1048576.0 : 0.0;
+    double secs = seconds_since(&progress->start);
+    
+    printf("\n%.1f MiB in %.2f s (%.1f MiB/s)\n", mib, secs, secs > 0 ? mib / secs : 0.0);
+}
+
 /* ============================================================================
  * Command implementations
  * ========================================================================= */
@@ -115,13 +220,38 @@ int cmd_add(Database *db, int argc, char **argv) {
 }
 
 int cmd_list(Database *db, int argc, char **argv) {
-    (void)argc;
-    (void)argv;
+    int limit = 0;
+    int after_id = 0;
+    BookSort sort = BOOK_SORT_TITLE;
     
-    Book **books = NULL;
-    int count = 0;
+    // Parse options
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--limit") == 0 && i + 1 < argc) {
+            limit = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--after") == 0 && i + 1 < argc) {
+            after_id = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--sort") == 0 && i + 1 < argc) {
+            const char *key = argv[++i];
+            if (strcmp(key, "title") == 0) {
+                sort = BOOK_SORT_TITLE;
+            } else if (strcmp(key, "added") == 0) {
+                sort = BOOK_SORT_ADDED;
+            } else {
+                fprintf(stderr, "Error: Unknown sort key '%s' (use title or added)\n", key);
+                return 1;
+            }
+        }
+    }
+    if (limit < 0 || after_id < 0) {
+        fprintf(stderr, "Error: --limit and --after must be positive\n");
+        return 1;
+    }
+    if (after_id > 0 && limit == 0) {
+        limit = DEFAULT_PAGE_SIZE;
+    }
     
-    BnError err = db_book_get_all(db, &books, &count);
+    int count = 0;
+    BnError err = db_book_count(db, &count);
     if (err != BN_SUCCESS) {
         bn_print_error(err, "listing books");
         return 1;
@@ -134,18 +264,44 @@ int cmd_list(Database *db, int argc, char **argv) {
     }
     
     printf("Books in library: %d\n\n", count);
-    for (int i = 0; i < count; i++) {
-        printf("[%d] %s", books[i]->id, books[i]->title);
-        if (books[i]->author) {
-            printf(" - %s", books[i]->author);
+    
+    if (limit > 0) {
+        BookResultSet *page = NULL;
+        err = db_book_get_page(db, sort, after_id, limit, &page);
+        if (err != BN_SUCCESS) {
+            bn_print_error(err, "listing books");
+            return 1;
+        }
+        
+        for (int i = 0; i < page->count; i++) {
+            print_book_line(&page->books[i]);
         }
-        if (books[i]->year > 0) {
-            printf(" (%d)", books[i]->year);
+        if (page->count == limit) {
+            printf("\nNext page: booknote list --limit %d --after %d%s\n", limit,
+                   page->books[page->count - 1].id, sort == BOOK_SORT_ADDED ? " --sort added" : "");
         }
-        printf("\n");
-        book_free(books[i]);
+        
+        db_book_result_free(page);
+        return 0;
+    }
+    
+    BookCursor *cursor = NULL;
+    err = db_book_cursor_open(db, sort, &cursor);
+    if (err != BN_SUCCESS) {
+        bn_print_error(err, "listing books");
+        return 1;
+    }
+    
+    const Book *book = NULL;
+    while ((err = db_book_cursor_next(cursor, &book)) == BN_SUCCESS && book) {
+        print_book_line(book);
+    }
+    db_book_cursor_close(cursor);
+    
+    if (err != BN_SUCCESS) {
+        bn_print_error(err, "listing books");
+        return 1;
     }
-    free(books);
     
     return 0;
 }
@@ -153,7 +309,7 @@ int cmd_list(Database *db, int argc, char **argv) {
 int cmd_show(Database *db, int argc, char **argv) {
     if (argc < 3) {
         fprintf(stderr, "Error: Missing book ID\n");
-        fprintf(stderr, "Usage: booknote show <book-id>\n");
+        fprintf(stderr, "Usage: booknote show <book-id> [--limit N] [--after NOTE-ID] [--sort created|page]\n");
         return 1;
     }
     
@@ -163,6 +319,36 @@ int cmd_show(Database *db, int argc, char **argv) {
         return 1;
     }
     
+    int limit = 0;
+    int after_id = 0;
+    NoteSort sort = NOTE_SORT_CREATED;
+    
+    // Parse options
+    for (int i = 3; i < argc; i++) {
+        if (strcmp(argv[i], "--limit") == 0 && i + 1 < argc) {
+            limit = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--after") == 0 && i + 1 < argc) {
+            after_id = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--sort") == 0 && i + 1 < argc) {
+            const char *key = argv[++i];
+            if (strcmp(key, "created") == 0) {
+                sort = NOTE_SORT_CREATED;
+            } else if (strcmp(key, "page") == 0) {
+                sort = NOTE_SORT_PAGE;
+            } else {
+                fprintf(stderr, "Error: Unknown sort key '%s' (use created or page)\n", key);
+                return 1;
+            }
+        }
+    }
+    if (limit < 0 || after_id < 0) {
+        fprintf(stderr, "Error: --limit and --after must be positive\n");
+        return 1;
+    }
+    if (after_id > 0 && limit == 0) {
+        limit = DEFAULT_PAGE_SIZE;
+    }
+    
     // Get book
     Book *book = NULL;
     BnError err = db_book_get_by_id(db, book_id, &book);
@@ -195,25 +381,44 @@ int cmd_show(Database *db, int argc, char **argv) {
     
     // Get notes
     printf("\n=== Notes ===\n");
-    Note **notes = NULL;
     int note_count = 0;
-    err = db_note_get_by_book(db, book_id, &notes, &note_count);
+    err = db_note_count_by_book(db, book_id, &note_count);
     
     if (err != BN_SUCCESS) {
         bn_print_error(err, "getting notes");
     } else if (note_count == 0) {
         printf("No notes yet. Add one with: booknote note %d \"your note\"\n", book_id);
+    } else if (limit > 0) {
+        printf("Total notes: %d\n\n", note_count);
+        NoteResultSet *page = NULL;
+        err = db_note_get_page_by_book(db, book_id, sort, after_id, limit, &page);
+        if (err != BN_SUCCESS) {
+            bn_print_error(err, "getting notes");
+        } else {
+            for (int i = 0; i < page->count; i++) {
+                print_note_line(&page->notes[i]);
+            }
+            if (page->count == limit) {
+                printf("\nNext page: booknote show %d --limit %d --after %d%s\n", book_id, limit,
+                       page->notes[page->count - 1].id, sort == NOTE_SORT_PAGE ? " --sort page" : "");
+            }
+            db_note_result_free(page);
+        }
     } else {
         printf("Total notes: %d\n\n", note_count);
-        for (int i = 0; i < note_count; i++) {
-            printf("[%d] ", notes[i]->id);
-            if (notes[i]->page_number > 0) {
-                printf("(page %d) ", notes[i]->page_number);
+        NoteCursor *cursor = NULL;
+        err = db_note_cursor_open_by_book(db, book_id, sort, &cursor);
+        if (err == BN_SUCCESS) {
+            const Note *note = NULL;
+            while ((err = db_note_cursor_next(cursor, &note)) == BN_SUCCESS && note) {
+                print_note_line(note);
             }
-            printf("%s\n", notes[i]->content);
-            note_free(notes[i]);
+            db_note_cursor_close(cursor);
+        }
+        
+        if (err != BN_SUCCESS) {
+            bn_print_error(err, "getting notes");
         }
-        free(notes);
     }
     
     book_free(book);
@@ -282,19 +487,89 @@ int cmd_note(Database *db, int argc, char **argv) {
     return 0;
 }
 
-int cmd_search(Database *db, int argc, char **argv) {
-    if (argc < 3) {
-        fprintf(stderr, "Error: Missing search query\n");
-        fprintf(stderr, "Usage: booknote search <\"query\">\n");
+/* Word search over notes and indexed PDF pages, merged by rank */
+static int search_library(Database *db, const char *query, const char *match, const SearchOptions *opts) {
+    LibrarySearchCursor *cursor = NULL;
+    BnError err = db_library_search(db, match, opts, &cursor);
+    if (err != BN_SUCCESS) {
+        bn_print_error(err, "searching");
         return 1;
     }
     
-    char *query = argv[2];
+    int notes = 0;
+    int pages = 0;
+    const LibraryHit *hit = NULL;
+    while ((err = db_library_search_next(cursor, &hit)) == BN_SUCCESS && hit) {
+        if (notes + pages == 0) {
+            printf("Matches for: \"%s\"\n\n", query);
+        }
+        
+        if (hit->kind == LIBRARY_HIT_NOTE) {
+            notes++;
+            printf("[%d] (%s) ", hit->note_id, hit->book_title);
+        } else {
+            pages++;
+            printf("[pdf] (%s) ", hit->book_title);
+        }
+        if (hit->page_number > 0) {
+            printf("page %d: ", hit->page_number);
+        }
+        printf("%s\n", hit->snippet);
+    }
+    db_library_search_close(cursor);
+    
+    if (err != BN_SUCCESS) {
+        bn_print_error(err, "searching");
+        return 1;
+    }
+    
+    if (notes + pages == 0) {
+        printf("No notes or pages found matching: \"%s\"\n", query);
+        return 0;
+    }
+    
+    printf("\nFound %d note(s) and %d PDF page(s)", notes, pages);
+    if (notes + pages == opts->limit) {
+        printf(" (showing the best %d; use --limit 0 for all)", opts->limit);
+    }
+    printf("\n");
+    return 0;
+}
+
+/* Ranked search over notes only, in any match mode */
+static int search_notes(Database *db, const char *query, const char *match, const SearchOptions *opts) {
+    SearchCursor *cursor = NULL;
+    BnError err = db_note_search_ranked(db, match, opts, &cursor);
+    if (err == BN_ERROR_NOT_FOUND) {
+        fprintf(stderr, "Error: Substring search index is not enabled\n");
+        fprintf(stderr, "Enable it with: booknote reindex --substring\n");
+        return 1;
+    }
+    if (err == BN_ERROR_INVALID_ARG && opts->mode != SEARCH_MODE_WORDS) {
+        fprintf(stderr, "Error: Substring search needs at least 3 characters\n");
+        return 1;
+    }
+    if (err != BN_SUCCESS) {
+        bn_print_error(err, "searching notes");
+        return 1;
+    }
     
-    Note **notes = NULL;
     int count = 0;
+    const SearchHit *hit = NULL;
+    while ((err = db_search_cursor_next(cursor, &hit)) == BN_SUCCESS && hit) {
+        if (count == 0) {
+            printf("Notes matching: \"%s\"\n\n", query);
+        }
+        count++;
+        
+        printf("[%d] (%s) ", hit->note_id, hit->book_title);
+        if (hit->page_number > 0) {
+            printf("page %d: ", hit->page_number);
+        }
+        printf("%s\n", hit->snippet);
+    }
+    db_search_cursor_close(cursor);
     
-    BnError err = db_note_search(db, query, &notes, &count);
     if (err != BN_SUCCESS) {
         bn_print_error(err, "searching notes");
         return 1;
@@ -305,27 +580,164 @@ int cmd_search(Database *db, int argc, char **argv) {
         return 0;
     }
     
-    printf("Found %d note(s) matching: \"%s\"\n\n", count, query);
+    printf("\nFound %d note(s)", count);
+    if (count == opts->limit) {
+        printf(" (showing the best %d; use --limit 0 for all)", opts->limit);
+    }
+    printf("\n");
+    return 0;
+}
+
+int cmd_search(Database *db, int argc, char **argv) {
+    if (argc < 3) {
+        fprintf(stderr, "Error: Missing search query\n");
+        fprintf(stderr, "Usage: booknote search <\"query\"> [--limit N] [--notes] [--substring | --fuzzy]\n");
+        return 1;
+    }
+    
+    char *query = argv[2];
     
-    for (int i = 0; i < count; i++) {
-        // Get book info for context
-        Book *book = NULL;
-        err = db_book_get_by_id(db, notes[i]->book_id, &book);
-        
-        printf("[%d] ", notes[i]->id);
-        if (book) {
-            printf("(%s) ", book->title);
-            book_free(book);
+    SearchOptions opts;
+    db_search_options_init(&opts);
+    opts.limit = DEFAULT_SEARCH_LIMIT;
+    int notes_only = 0;
+    
+    // Parse options: limit (0 = all), sources and match mode
+    for (int i = 3; i < argc; i++) {
+        if (strcmp(argv[i], "--limit") == 0 && i + 1 < argc) {
+            opts.limit = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--notes") == 0) {
+            notes_only = 1;
+        } else if (strcmp(argv[i], "--substring") == 0) {
+            opts.mode = SEARCH_MODE_SUBSTRING;
+        } else if (strcmp(argv[i], "--fuzzy") == 0) {
+            opts.mode = SEARCH_MODE_FUZZY;
         }
-        if (notes[i]->page_number > 0) {
-            printf("page %d: ", notes[i]->page_number);
+    }
+    if (opts.limit < 0) {
+        fprintf(stderr, "Error: --limit must be positive (0 for all)\n");
+        return 1;
+    }
+    
+    // Highlight matches in bold on a terminal, Markdown-style otherwise
+    if (isatty(fileno(stdout))) {
+        opts.mark_open = "\033[1m";
+        opts.mark_close = "\033[0m";
+    } else {
+        opts.mark_open = "**";
+        opts.mark_close = "**";
+    }
+    
+    // Words are literal apart from phrases and operators (see
+    // db_fts_word_query); the trigram
+    // modes quote the text themselves
+    char *match = NULL;
+    if (opts.mode == SEARCH_MODE_WORDS) {
+        BnError err = db_fts_word_query(query, DB_FTS_OPERATORS, &match);
+        if (err == BN_ERROR_OUT_OF_MEMORY) {
+            fprintf(stderr, "Error: %s\n", bn_error_string(err));
+            return 1;
+        }
+        if (err != BN_SUCCESS) {
+            fprintf(stderr, "Error: Missing search query\n");
+            return 1;
+        }
+    }
+    
+    // PDF pages only have a word index
+    int result = opts.mode == SEARCH_MODE_WORDS && !notes_only
+        ? search_library(db, query, match, &opts)
+        : search_notes(db, query, match ? match : query, &opts);
+    free(match);
+    return result;
+}
+
+int cmd_find(Database *db, int argc, char **argv) {
+    if (argc < 3) {
+        fprintf(stderr, "Error: Missing search text\n");
+        fprintf(stderr, "Usage: booknote find <\"text\"> [--limit N]\n");
+        return 1;
+    }
+    
+    char *text = argv[2];
+    int limit = DEFAULT_SEARCH_LIMIT;
+    
+    // Parse optional limit (0 = all)
+    for (int i = 3; i < argc; i++) {
+        if (strcmp(argv[i], "--limit") == 0 && i + 1 < argc) {
+            limit = atoi(argv[++i]);
+        }
+    }
+    if (limit < 0) {
+        fprintf(stderr, "Error: --limit must be positive (0 for all)\n");
+        return 1;
+    }
+    
+    BookResultSet *set = NULL;
+    BnError err = db_book_search(db, text, limit, &set);
+    if (err != BN_SUCCESS) {
+        bn_print_error(err, "finding books");
+        return 1;
+    }
+    
+    if (set->count == 0) {
+        printf("No books found matching: \"%s\"\n", text);
+        db_book_result_free(set);
+        return 0;
+    }
+    
+    printf("Books matching: \"%s\"\n\n", text);
+    for (int i = 0; i < set->count; i++) {
+        print_book_line(&set->books[i]);
+    }
+    printf("\nFound %d book(s)\n", set->count);
+    
+    db_book_result_free(set);
+    return 0;
+}
+
+int cmd_reindex(Database *db, int argc, char **argv) {
+    int substring = -1;     // Leave the trigram index as it is
+    
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--substring") == 0) {
+            substring = 1;
+        } else if (strcmp(argv[i], "--no-substring") == 0) {
+            substring = 0;
+        }
+    }
+    
+    long long before = 0;
+    BnError err = db_fts_index_size(db, &before);
+    if (err != BN_SUCCESS) {
+        bn_print_error(err, "reading index size");
+        return 1;
+    }
+    
+    if (substring >= 0) {
+        printf("%s substring search index...\n", substring ? "Building" : "Dropping");
+        err = db_fts_set_substring_index(db, substring);
+        if (err != BN_SUCCESS) {
+            bn_print_error(err, "updating substring index");
+            return 1;
         }
-        printf("%s\n", notes[i]->content);
-        
-        note_free(notes[i]);
     }
-    free(notes);
     
+    printf("Rebuilding search indexes...\n");
+    err = db_fts_reindex(db);
+    if (err != BN_SUCCESS) {
+        bn_print_error(err, "rebuilding search indexes");
+        return 1;
+    }
+    
+    long long after = 0;
+    err = db_fts_index_size(db, &after);
+    if (err != BN_SUCCESS) {
+        bn_print_error(err, "reading index size");
+        return 1;
+    }
+    
+    printf("Index size: %.1f KiB -> %.1f KiB\n", before / 1024.0, after / 1024.0);
     return 0;
 }
 
@@ -374,3 +786,457 @@ int cmd_delete(Database *db, int argc, char **argv) {
     printf("Book deleted (including all notes).\n");
     return 0;
 }
+
+int cmd_import_notes(Database *db, int argc, char **argv) {
+    if (argc < 3) {
+        fprintf(stderr, "Error: Missing input file\n");
+        fprintf(stderr, "Usage: booknote import-notes <file|->\n");
+        return 1;
+    }
+    
+    const char *path = argv[2];
+    FILE *in = strcmp(path, "-") == 0 ? stdin : fopen(path, "r");
+    if (!in) {
+        bn_print_error(BN_ERROR_FILE_NOT_FOUND, path);
+        return 1;
+    }
+    
+    Note *batch[IMPORT_BATCH_SIZE];
+    long lines[IMPORT_BATCH_SIZE];
+    BnError row_errors[IMPORT_BATCH_SIZE];
+    int batch_count = 0;
+    int imported = 0;
+    int failed = 0;
+    int status = 0;
+    
+    char *line = NULL;
+    size_t line_cap = 0;
+    long line_no = 0;
+    
+    while (getline(&line, &line_cap, in) != -1) {
+        line_no++;
+        
+        // Skip blank lines
+        const char *p = line;
+        while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') {
+            p++;
+        }
+        if (*p == '\0') {
+            continue;
+        }
+        
+        Note *note = NULL;
+        BnError err = db_note_from_json(db, line, &note);
+        if (err != BN_SUCCESS) {
+            fprintf(stderr, "Line %ld: %s\n", line_no,
+                    err == BN_ERROR_INVALID_ARG ? "Malformed note (need book_id and content)" : bn_error_string(err));
+            failed++;
+            continue;
+        }
+        
+        batch[batch_count] = note;
+        lines[batch_count] = line_no;
+        batch_count++;
+        
+        if (batch_count == IMPORT_BATCH_SIZE) {
+            status = flush_note_batch(db, batch, lines, row_errors, batch_count, &imported, &failed);
+            batch_count = 0;
+            if (status != 0) {
+                break;
+            }
+        }
+    }
+    
+    if (status == 0 && batch_count > 0) {
+        status = flush_note_batch(db, batch, lines, row_errors, batch_count, &imported, &failed);
+    } else {
+        // Aborted mid-file: drop whatever was parsed but not inserted
+        for (int i = 0; i < batch_count; i++) {
+            note_free(batch[i]);
+        }
+    }
+    
+    free(line);
+    if (in != stdin) {
+        fclose(in);
+    }
+    
+    printf("Imported %d note(s)", imported);
+    if (failed > 0) {
+        printf(", %d failed", failed);
+    }
+    printf("\n");
+    
+    return (status != 0 || failed > 0) ? 1 : 0;
+}
+
+int cmd_backup(Database *db, int argc, char **argv) {
+    if (argc < 3) {
+        fprintf(stderr, "Error: Missing backup path\n");
+        fprintf(stderr, "Usage: booknote backup <path> [--force]\n");
+        return 1;
+    }
+    
+    const char *path = argv[2];
+    int force = 0;
+    for (int i = 3; i < argc; i++) {
+        if (strcmp(argv[i], "--force") == 0) {
+            force = 1;
+        }
+    }
+    
+    if (!force && access(path, F_OK) == 0) {
+        fprintf(stderr, "Error: %s already exists (use --force to replace it)\n", path);
+        return 1;
+    }
+    
+    CopyProgress progress = { "Backing up", { 0, 0 }, -1 };
+    clock_gettime(CLOCK_MONOTONIC, &progress.start);
+    
+    BnError err = db_backup_to(db, path, print_copy_progress, &progress);
+    if (err != BN_SUCCESS) {
+        if (progress.last_percent >= 0) {
+            printf("\n");
+        }
+        bn_print_error(err, "writing backup");
+        return 1;
+    }
+    
+    print_copy_summary(&progress, path);
+    printf("Backup written to %s\n", path);
+    return 0;
+}
+
+int cmd_restore(Database *db, int argc, char **argv) {
+    if (argc < 3) {
+        fprintf(stderr, "Error: Missing backup path\n");
+        fprintf(stderr, "Usage: booknote restore <path> [--yes]\n");
+        return 1;
+    }
+    
+    const char *path = argv[2];
+    int yes = 0;
+    for (int i = 3; i < argc; i++) {
+        if (strcmp(argv[i], "--yes") == 0) {
+            yes = 1;
+        }
+    }
+    
+    if (access(path, R_OK) != 0) {
+        bn_print_error(BN_ERROR_FILE_NOT_FOUND, path);
+        return 1;
+    }
+    
+    if (!yes) {
+        printf("Replace the whole library with %s? (y/N): ", path);
+        char confirm[10];
+        if (!fgets(confirm, sizeof(confirm), stdin) || confirm[0] != 'y') {
+            printf("Cancelled.\n");
+            return 0;
+        }
+    }
+    
+    CopyProgress progress = { "Restoring", { 0, 0 }, -1 };
+    clock_gettime(CLOCK_MONOTONIC, &progress.start);
+    
+    BnError err = db_restore_from(db, path, print_copy_progress, &progress);
+    if (err != BN_SUCCESS) {
+        if (progress.last_percent >= 0) {
+            printf("\n");
+        }
+        if (err == BN_ERROR_INVALID_ARG) {
+            fprintf(stderr, "Error: %s is not a booknote database this version can read\n", path);
+        } else {
+            bn_print_error(err, "restoring backup");
+        }
+        return 1;
+    }
+    
+    print_copy_summary(&progress, path);
+    printf("Library restored from %s\n", path);
+    return 0;
+}
+
+/* Totals and note/page breakdown of one book */
+static int print_book_stats(Database *db, int book_id, int bucket_size) {
+    Book *book = NULL;
+    BnError err = db_book_get_by_id(db, book_id, &book);
+    if (err != BN_SUCCESS) {
+        if (err == BN_ERROR_NOT_FOUND) {
+            fprintf(stderr, "Error: Book not found (ID: %d)\n", book_id);
+        } else {
+            bn_print_error(err, "loading book");
+        }
+        return 1;
+    }
+    
+    int note_count = 0;
+    err = db_note_count_by_book(db, book_id, &note_count);
+    
+    PageRangeCount *ranges = NULL;
+    int range_count = 0;
+    if (err == BN_SUCCESS) {
+        err = db_note_page_ranges(db, book_id, bucket_size, &ranges, &range_count);
+    }
+    if (err != BN_SUCCESS) {
+        bn_print_error(err, "computing statistics");
+        book_free(book);
+        return 1;
+    }
+    
+    printf("Statistics for [%d] %s\n\n", book->id, book->title);
+    printf("  Notes: %d\n", note_count);
+    
+    int paged = 0;
+    for (int i = 0; i < range_count; i++) {
+        paged += ranges[i].note_count;
+    }
+    if (note_count > 0) {
+        printf("\nNotes per page range:\n");
+    }
+    for (int i = 0; i < range_count; i++) {
+        printf("  %5d-%-5d %5d\n", ranges[i].first_page, ranges[i].last_page, ranges[i].note_count);
+    }
+    if (note_count > paged) {
+        printf("  %-11s %5d\n", "no page", note_count - paged);
+    }
+    
+    free(ranges);
+    book_free(book);
+    return 0;
+}
+
+static void print_book_stats_rows(const BookStatsSet *set) {
+    char when[32];
+    for (int i = 0; i < set->count; i++) {
+        const BookStats *row = &set->rows[i];
+        format_timestamp(row->last_updated, when, sizeof(when));
+        printf("  [%d] %s - %d note(s), %lld word(s), updated %s\n",
+               row->book_id, row->title, row->note_count, row->word_count, when);
+    }
+}
+
+static int print_library_stats(Database *db, int top) {
+    LibraryTotals totals;
+    BnError err = db_library_totals(db, &totals);
+    if (err != BN_SUCCESS) {
+        bn_print_error(err, "computing statistics");
+        return 1;
+    }
+    
+    char when[32];
+    format_timestamp(totals.last_updated, when, sizeof(when));
+    printf("Library statistics\n\n");
+    printf("  Books:          %d\n", totals.books);
+    printf("  Notes:          %d (%d with a page number)\n", totals.notes, totals.paged_notes);
+    printf("  Words in notes: %lld\n", totals.words);
+    if (totals.books > 0) {
+        printf("  Notes per book: %.1f\n", (double)totals.notes / totals.books);
+    }
+    printf("  Last update:    %s\n", when);
+    
+    if (totals.books == 0) {
+        return 0;
+    }
+    
+    BookStatsSet *set = NULL;
+    err = db_book_stats(db, BOOK_STATS_BY_NOTES, top, &set);
+    if (err == BN_SUCCESS) {
+        printf("\nMost annotated:\n");
+        print_book_stats_rows(set);
+        db_book_stats_free(set);
+        err = db_book_stats(db, BOOK_STATS_BY_UPDATED, top, &set);
+    }
+    if (err == BN_SUCCESS) {
+        printf("\nRecently updated:\n");
+        print_book_stats_rows(set);
+        db_book_stats_free(set);
+    }
+    if (err != BN_SUCCESS) {
+        bn_print_error(err, "computing statistics");
+        return 1;
+    }
+    
+    return 0;
+}
+
+int cmd_stats(Database *db, int argc, char **argv) {
+    int book_id = 0;
+    int top = 5;
+    int bucket_size = 50;
+    int queries = 0;
+    
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--top") == 0 && i + 1 < argc) {
+            top = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--page-range") == 0 && i + 1 < argc) {
+            bucket_size = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--queries") == 0) {
+            queries = 1;
+        } else if (book_id == 0) {
+            book_id = atoi(argv[i]);
+            if (book_id <= 0) {
+                fprintf(stderr, "Error: Invalid book ID\n");
+                return 1;
+            }
+        }
+    }
+    if (top <= 0 || bucket_size <= 0) {
+        fprintf(stderr, "Error: --top and --page-range must be positive\n");
+        return 1;
+    }
+    
+    // --queries: time the statistics queries themselves; with --trace-queries
+    // the report is already printed at exit
+    int own_trace = queries && !db->tracing;
+    if (own_trace) {
+        BnError err = db_trace_enable(db, -1);
+        if (err != BN_SUCCESS) {
+            bn_print_error(err, "enabling query tracing");
+            return 1;
+        }
+    }
+    
+    int result = book_id > 0 ? print_book_stats(db, book_id, bucket_size)
+                             : print_library_stats(db, top);
+    
+    if (own_trace) {
+        db_trace_report(db, stdout);
+        db_trace_disable(db);
+    }
+    return result;
+}
+
+/*
+ * Extract one book's PDF and print its throughput; adds to the totals.
+ * Returns 1 if the file was unchanged, 0 if indexed, -1 if skipped
+ */
+static int index_book_pdf(Database *db, const Book *book, int threads, int flags, PdfIndexStats *totals) {
+    if (access(book->filepath, R_OK) != 0) {
+        fprintf(stderr, "[%d] %s: cannot read %s, skipped\n", book->id, book->title, book->filepath);
+        return -1;
+    }
+    
+    PdfIndexStats stats;
+    BnError err = pdftext_index_book(db, book->id, book->filepath, threads, flags, &stats);
+    if (err != BN_SUCCESS) {
+        fprintf(stderr, "[%d] %s: %s\n", book->id, book->title,
+                err == BN_ERROR_FILE_NOT_FOUND ? "not a readable PDF" : bn_error_string(err));
+        return -1;
+    }
+    if (stats.unchanged) {
+        return 1;
+    }
+    
+    printf("[%d] %s: %d page(s), %d with text, %.2f s (%.0f pages/s)\n",
+           book->id, book->title, stats.pages, stats.stored_pages, stats.total_seconds,
+           stats.total_seconds > 0 ? stats.pages / stats.total_seconds : 0.0);
+    
+    totals->pages += stats.pages;
+    totals->stored_pages += stats.stored_pages;
+    totals->chars += stats.chars;
+    totals->threads = stats.threads;
+    totals->extract_seconds += stats.extract_seconds;
+    totals->total_seconds += stats.total_seconds;
+    return 0;
+}
+
+int cmd_index_pdf(Database *db, int argc, char **argv) {
+    int book_id = 0;
+    int threads = 0;
+    int flags = 0;
+    
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--force") == 0) {
+            flags |= PDFTEXT_FORCE;
+        } else if (book_id == 0) {
+            book_id = atoi(argv[i]);
+            if (book_id <= 0) {
+                fprintf(stderr, "Error: Invalid book ID\n");
+                return 1;
+            }
+        }
+    }
+    
+    if (!pdftext_available()) {
+        fprintf(stderr, "Error: booknote was built without Poppler; install poppler-glib and rebuild\n");
+        return 1;
+    }
+    
+    PdfIndexStats totals;
+    memset(&totals, 0, sizeof(totals));
+    int failed = 0;
+    
+    if (book_id > 0) {
+        Book *book = NULL;
+        BnError err = db_book_get_by_id(db, book_id, &book);
+        if (err != BN_SUCCESS) {
+            if (err == BN_ERROR_NOT_FOUND) {
+                fprintf(stderr, "Error: Book not found (ID: %d)\n", book_id);
+            } else {
+                bn_print_error(err, "loading book");
+            }
+            return 1;
+        }
+        
+        int rc = index_book_pdf(db, book, threads, flags, &totals);
+        if (rc == 1) {
+            printf("[%d] %s: unchanged since last indexed (use --force to re-extract)\n",
+                   book->id, book->title);
+        }
+        book_free(book);
+        return rc < 0;
+    }
+    
+    // Pages and fingerprints of books deleted without foreign keys on
+    int purged = 0;
+    BnError err = db_pdf_pages_purge_orphans(db, &purged);
+    if (err != BN_SUCCESS) {
+        bn_print_error(err, "purging stale pages");
+        return 1;
+    }
+    
+    BookResultSet *set = NULL;
+    err = db_book_get_all_arena(db, &set);
+    if (err != BN_SUCCESS) {
+        bn_print_error(err, "listing books");
+        return 1;
+    }
+    
+    int unchanged = 0;
+    for (int i = 0; i < set->count; i++) {
+        int rc = index_book_pdf(db, &set->books[i], threads, flags, &totals);
+        if (rc < 0) {
+            failed++;
+        } else if (rc == 1) {
+            unchanged++;
+        }
+    }
+    int indexed = set->count - failed - unchanged;
+    db_book_result_free(set);
+    
+    if (indexed > 0) {
+        printf("\nIndexed %d book(s), %d page(s) (%.1f MiB of text) with %d thread(s)\n",
+               indexed, totals.pages, totals.chars / 1048576.0, totals.threads);
+    } else {
+        printf("\nNo PDF needed indexing\n");
+    }
+    if (unchanged > 0) {
+        printf("%d book(s) unchanged since last indexed\n", unchanged);
+    }
+    if (purged > 0) {
+        printf("Removed %d stale row(s) of deleted books\n", purged);
+    }
+    if (totals.total_seconds > 0) {
+        printf("Extraction %.0f pages/s, overall %.0f pages/s\n",
+               totals.extract_seconds > 0 ? totals.pages / totals.extract_seconds : 0.0,
+               totals.pages / totals.total_seconds);
+    }
+    if (failed > 0) {
+        printf("%d book(s) skipped\n", failed);
+    }
+    
+    return failed > 0 ? 1 : 0;
+}
@@ -16,13 +16,13 @@ int cmd_add(Database *db, int argc, char **argv);
 
 /**
  * List all books
- * Usage: booknote list
+ * Usage: booknote list [--limit N] [--after BOOK-ID] [--sort title|added]
  */
 int cmd_list(Database *db, int argc, char **argv);
 
 /**
  * Show book details and notes
- * Usage: booknote show <book-id>
+ * Usage: booknote show <book-id> [--limit N] [--after NOTE-ID] [--sort created|page]
  */
 int cmd_show(Database *db, int argc, char **argv);
 
@@ -33,17 +33,69 @@ int cmd_show(Database *db, int argc, char **argv);
 int cmd_note(Database *db, int argc, char **argv);
 
 /**
- * Search notes
- * Usage: booknote search <"query">
+ * Search notes and indexed PDF pages, merged by relevance
+ * --notes, --substring and --fuzzy search notes only.
+ * Usage: booknote search <"query"> [--limit N] [--notes] [--substring | --fuzzy]
  */
 int cmd_search(Database *db, int argc, char **argv);
 
+/**
+ * Find books by title, author, publisher or ISBN prefix
+ * Usage: booknote find <"text"> [--limit N]
+ */
+int cmd_find(Database *db, int argc, char **argv);
+
+/**
+ * Rebuild and optimize the full-text indexes
+ * --substring builds the trigram index used by search --substring/--fuzzy,
+ * --no-substring drops it.
+ * Usage: booknote reindex [--substring | --no-substring]
+ */
+int cmd_reindex(Database *db, int argc, char **argv);
+
 /**
  * Delete a book
  * Usage: booknote delete <book-id>
  */
 int cmd_delete(Database *db, int argc, char **argv);
 
+/**
+ * Import notes from newline-delimited JSON
+ * Each line is {"book_id": N, "content": "...", "title": "...", "page": N}.
+ * Usage: booknote import-notes <file|->
+ */
+int cmd_import_notes(Database *db, int argc, char **argv);
+
+/**
+ * Extract the text of a book's PDF (or of every book) into the page index
+ * Pages are extracted by a pool of threads, one per CPU unless --threads
+ * is given. Files unchanged since they were last indexed are skipped
+ * unless --force is given. Needs a build with Poppler.
+ * Usage: booknote index-pdf [book-id] [--threads N] [--force]
+ */
+int cmd_index_pdf(Database *db, int argc, char **argv);
+
+/**
+ * Show library statistics (totals, most annotated and recently updated
+ * books), or one book's note count per page range
+ * Usage: booknote stats [book-id] [--top N] [--page-range PAGES]
+ */
+int cmd_stats(Database *db, int argc, char **argv);
+
+/**
+ * Copy the library to a file using the online backup API
+ * Refuses to overwrite an existing file unless --force is given.
+ * Usage: booknote backup <path> [--force]
+ */
+int cmd_backup(Database *db, int argc, char **argv);
+
+/**
+ * Replace the library with a backup made by `booknote backup`
+ * Asks for confirmation unless --yes is given.
+ * Usage: booknote restore <path> [--yes]
+ */
+int cmd_restore(Database *db, int argc, char **argv);
+
 /**
  * Show help
  * Usage: booknote help [command]
@@ -48,6 +48,7 @@ void book_free(Book *book) {
     free(book->author);
     free(book->publisher);
     free(book->filepath);
+    free(book->cover_path);
     free(book);
 }
 
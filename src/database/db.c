@@ -6,20 +6,24 @@
 #include <string.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <time.h>
 #include <unistd.h>
 #include <pwd.h>
 
 static BnError ensure_directory_exists(const char *path) {
+    // In-memory databases and URIs have no directory to create, and a bare
+    // file name lives in the working directory
+    if (strcmp(path, ":memory:") == 0 || strncmp(path, "file:", 5) == 0 || !strchr(path, '/')) {
+        return BN_SUCCESS;
+    }
+    
     char *dir_path = strdup(path);
     if (!dir_path) {
         return BN_ERROR_OUT_OF_MEMORY;
     }
     
     // Remove filename to get directory
-    char *last_slash = strrchr(dir_path, '/');
-    if (last_slash) {
-        *last_slash = '\0';
-    }
+    *strrchr(dir_path, '/') = '\0';
     
     // Create directory recursively
     char *p = dir_path;
@@ -68,11 +72,140 @@ BnError db_get_default_path(char **out_path) {
     return BN_SUCCESS;
 }
 
+#define STMT_CACHE_INITIAL_CAPACITY 16
+
+static void change_dispatch(Database *db);
+
+/* Finalize every cached statement; the hit/miss counters are kept */
+static void stmt_cache_clear(Database *db) {
+    for (int i = 0; i < db->stmt_cache_count; i++) {
+        sqlite3_finalize(db->stmt_cache[i].stmt);
+        free(db->stmt_cache[i].sql);
+    }
+    free(db->stmt_cache);
+    db->stmt_cache = NULL;
+    db->stmt_cache_count = 0;
+    db->stmt_cache_capacity = 0;
+}
+
+void db_options_init(DbOptions *opts, DbProfile profile) {
+    if (!opts) {
+        return;
+    }
+    
+    memset(opts, 0, sizeof(DbOptions));
+    opts->busy_timeout_ms = 5000;
+    opts->slow_query_ms = -1;
+    
+    switch (profile) {
+        case DB_PROFILE_DURABLE:
+            opts->journal_mode = "DELETE";
+            opts->synchronous = "FULL";
+            break;
+        case DB_PROFILE_FAST:
+        default:
+            // WAL lets readers run during writes; NORMAL only fsyncs at checkpoints
+            opts->journal_mode = "WAL";
+            opts->synchronous = "NORMAL";
+            opts->mmap_size = 256LL * 1024 * 1024;
+            opts->cache_size_kib = 16 * 1024;
+            opts->temp_store_memory = 1;
+            break;
+    }
+}
+
+static BnError apply_options(sqlite3 *handle, const DbOptions *opts) {
+    char sql[128];
+    
+    if (opts->busy_timeout_ms > 0) {
+        sqlite3_busy_timeout(handle, opts->busy_timeout_ms);
+    }
+    
+    // Only the writer can change the journal mode
+    if (opts->journal_mode && !opts->read_only) {
+        snprintf(sql, sizeof(sql), "PRAGMA journal_mode = %s;", opts->journal_mode);
+        if (sqlite3_exec(handle, sql, NULL, NULL, NULL) != SQLITE_OK) {
+            return BN_ERROR_DATABASE;
+        }
+    }
+    
+    if (opts->synchronous) {
+        snprintf(sql, sizeof(sql), "PRAGMA synchronous = %s;", opts->synchronous);
+        if (sqlite3_exec(handle, sql, NULL, NULL, NULL) != SQLITE_OK) {
+            return BN_ERROR_DATABASE;
+        }
+    }
+    
+    snprintf(sql, sizeof(sql), "PRAGMA mmap_size = %lld;", opts->mmap_size);
+    sqlite3_exec(handle, sql, NULL, NULL, NULL);
+    
+    if (opts->cache_size_kib > 0) {
+        // Negative cache_size is interpreted as KiB rather than pages
+        snprintf(sql, sizeof(sql), "PRAGMA cache_size = -%d;", opts->cache_size_kib);
+        sqlite3_exec(handle, sql, NULL, NULL, NULL);
+    }
+    
+    if (opts->temp_store_memory) {
+        sqlite3_exec(handle, "PRAGMA temp_store = MEMORY;", NULL, NULL, NULL);
+    }
+    
+    return BN_SUCCESS;
+}
+
+void db_options_default(DbOptions *opts) {
+    const char *profile = getenv("BOOKNOTE_DB_PROFILE");
+    
+    if (profile && strcmp(profile, "durable") == 0) {
+        db_options_init(opts, DB_PROFILE_DURABLE);
+    } else {
+        db_options_init(opts, DB_PROFILE_FAST);
+    }
+    
+    const char *trace = getenv("BOOKNOTE_TRACE_QUERIES");
+    opts->trace_queries = trace && *trace && strcmp(trace, "0") != 0;
+    
+    const char *slow = getenv("BOOKNOTE_SLOW_QUERY_MS");
+    if (slow && *slow) {
+        opts->slow_query_ms = atoi(slow);
+    }
+}
+
+/* word_count(text): number of whitespace-separated words */
+static void sql_word_count(sqlite3_context *ctx, int argc, sqlite3_value **argv) {
+    (void)argc;
+    const unsigned char *text = sqlite3_value_text(argv[0]);
+    
+    sqlite3_int64 words = 0;
+    int in_word = 0;
+    for (const unsigned char *p = text; p && *p; p++) {
+        int space = (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r' || *p == '\f' || *p == '\v');
+        if (!space && !in_word) {
+            words++;
+        }
+        in_word = !space;
+    }
+    
+    sqlite3_result_int64(ctx, words);
+}
+
 BnError db_open(Database **out_db, const char *path) {
+    DbOptions opts;
+    db_options_default(&opts);
+    
+    return db_open_ex(out_db, path, &opts);
+}
+
+BnError db_open_ex(Database **out_db, const char *path, const DbOptions *opts) {
     if (!out_db) {
         return BN_ERROR_INVALID_ARG;
     }
     
+    DbOptions default_opts;
+    if (!opts) {
+        db_options_init(&default_opts, DB_PROFILE_FAST);
+        opts = &default_opts;
+    }
+    
     BnError err;
     char *db_path = NULL;
     
@@ -86,7 +219,7 @@ BnError db_open(Database **out_db, const char *path) {
     }
     
     // Ensure directory exists
-    err = ensure_directory_exists(path);
+    err = opts->read_only ? BN_SUCCESS : ensure_directory_exists(path);
     if (err != BN_SUCCESS) {
         free(db_path);
         return err;
@@ -99,8 +232,10 @@ BnError db_open(Database **out_db, const char *path) {
     }
     
     // Open SQLite database
-    int rc = sqlite3_open(path, &db->handle);
+    int flags = opts->read_only ? SQLITE_OPEN_READONLY : SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE;
+    int rc = sqlite3_open_v2(path, &db->handle, flags, NULL);
     if (rc != SQLITE_OK) {
+        sqlite3_close(db->handle);
         free(db);
         free(db_path);
         return BN_ERROR_DATABASE;
@@ -109,6 +244,20 @@ BnError db_open(Database **out_db, const char *path) {
     // Enable foreign keys
     sqlite3_exec(db->handle, "PRAGMA foreign_keys = ON;", NULL, NULL, NULL);
     
+    // Used by the statistics queries
+    sqlite3_create_function(db->handle, "word_count", 1,
+                            SQLITE_UTF8 | SQLITE_DETERMINISTIC | SQLITE_INNOCUOUS,
+                            NULL, sql_word_count, NULL, NULL);
+    
+    // Journal, sync and cache settings
+    err = apply_options(db->handle, opts);
+    if (err != BN_SUCCESS) {
+        sqlite3_close(db->handle);
+        free(db);
+        free(db_path);
+        return err;
+    }
+    
     // Store path
     db->path = db_path ? db_path : strdup(path);
     if (!db->path) {
@@ -117,9 +266,15 @@ BnError db_open(Database **out_db, const char *path) {
         return BN_ERROR_OUT_OF_MEMORY;
     }
     
-    // Initialize schema
-    err = schema_initialize(db->handle);
+    // Trace from the start so schema setup is covered too
+    if (opts->trace_queries || opts->slow_query_ms >= 0) {
+        db_trace_enable(db, opts->slow_query_ms);
+    }
+    
+    // Initialize schema (a read-only connection relies on the writer's)
+    err = opts->read_only ? BN_SUCCESS : schema_initialize(db->handle);
     if (err != BN_SUCCESS) {
+        db_trace_disable(db);
         sqlite3_close(db->handle);
         free(db->path);
         free(db);
@@ -135,6 +290,14 @@ void db_close(Database *db) {
         return;
     }
     
+    db_trace_disable(db);
+    
+    // Cached statements must be finalized before the handle can close
+    stmt_cache_clear(db);
+    
+    free(db->change_subscribers);
+    free(db->change_queue);
+    
     if (db->handle) {
         sqlite3_close(db->handle);
     }
@@ -143,6 +306,538 @@ void db_close(Database *db) {
     free(db);
 }
 
+BnError db_stmt_acquire(Database *db, const char *sql, sqlite3_stmt **out_stmt) {
+    if (!db || !db->handle || !sql || !out_stmt) {
+        return BN_ERROR_INVALID_ARG;
+    }
+    
+    DbCachedStmt *entry = NULL;
+    for (int i = 0; i < db->stmt_cache_count; i++) {
+        if (db->stmt_cache[i].sql == sql || strcmp(db->stmt_cache[i].sql, sql) == 0) {
+            entry = &db->stmt_cache[i];
+            break;
+        }
+    }
+    
+    if (entry && !entry->in_use) {
+        entry->in_use = 1;
+        db->stmt_cache_hits++;
+        *out_stmt = entry->stmt;
+        return BN_SUCCESS;
+    }
+    
+    db->stmt_cache_misses++;
+    
+    // Already checked out: hand out a private statement, finalized on release
+    if (entry) {
+        int rc = sqlite3_prepare_v2(db->handle, sql, -1, out_stmt, NULL);
+        return rc == SQLITE_OK ? BN_SUCCESS : BN_ERROR_DATABASE;
+    }
+    
+    if (db->stmt_cache_count == db->stmt_cache_capacity) {
+        int capacity = db->stmt_cache_capacity ? db->stmt_cache_capacity * 2 : STMT_CACHE_INITIAL_CAPACITY;
+        DbCachedStmt *cache = realloc(db->stmt_cache, capacity * sizeof(DbCachedStmt));
+        if (!cache) {
+            return BN_ERROR_OUT_OF_MEMORY;
+        }
+        db->stmt_cache = cache;
+        db->stmt_cache_capacity = capacity;
+    }
+    
+    char *key = strdup(sql);
+    if (!key) {
+        return BN_ERROR_OUT_OF_MEMORY;
+    }
+    
+    sqlite3_stmt *stmt;
+    int rc = sqlite3_prepare_v3(db->handle, sql, -1, SQLITE_PREPARE_PERSISTENT, &stmt, NULL);
+    if (rc != SQLITE_OK) {
+        free(key);
+        return BN_ERROR_DATABASE;
+    }
+    
+    entry = &db->stmt_cache[db->stmt_cache_count++];
+    entry->sql = key;
+    entry->stmt = stmt;
+    entry->in_use = 1;
+    
+    *out_stmt = stmt;
+    return BN_SUCCESS;
+}
+
+void db_stmt_release(Database *db, sqlite3_stmt *stmt) {
+    if (!db || !stmt) {
+        return;
+    }
+    
+    int cached = 0;
+    for (int i = 0; i < db->stmt_cache_count; i++) {
+        if (db->stmt_cache[i].stmt == stmt) {
+            sqlite3_reset(stmt);
+            sqlite3_clear_bindings(stmt);
+            db->stmt_cache[i].in_use = 0;
+            cached = 1;
+            break;
+        }
+    }
+    
+    // Not cached (handed out while the cached copy was busy)
+    if (!cached) {
+        sqlite3_finalize(stmt);
+    }
+    
+    // An autocommit write is committed once its statement is reset
+    if ((db->change_queue_count > 0 || db->change_queue_overflow) && sqlite3_get_autocommit(db->handle)) {
+        change_dispatch(db);
+    }
+}
+
+void db_stmt_cache_stats(const Database *db, unsigned long *out_hits, unsigned long *out_misses) {
+    if (out_hits) {
+        *out_hits = db ? db->stmt_cache_hits : 0;
+    }
+    if (out_misses) {
+        *out_misses = db ? db->stmt_cache_misses : 0;
+    }
+}
+
+/* ============================================================================
+ * Query tracing
+ * ========================================================================= */
+
+static DbQueryStats* trace_stats_for(Database *db, const char *sql) {
+    // Consecutive events usually come from the same statement
+    if (db->query_stats_last < db->query_stats_count &&
+        strcmp(db->query_stats[db->query_stats_last].sql, sql) == 0) {
+        return &db->query_stats[db->query_stats_last];
+    }
+    
+    for (int i = 0; i < db->query_stats_count; i++) {
+        if (strcmp(db->query_stats[i].sql, sql) == 0) {
+            db->query_stats_last = i;
+            return &db->query_stats[i];
+        }
+    }
+    
+    if (db->query_stats_count == db->query_stats_capacity) {
+        int capacity = db->query_stats_capacity ? db->query_stats_capacity * 2 : 32;
+        DbQueryStats *stats = realloc(db->query_stats, capacity * sizeof(DbQueryStats));
+        if (!stats) {
+            return NULL;
+        }
+        db->query_stats = stats;
+        db->query_stats_capacity = capacity;
+    }
+    
+    DbQueryStats *entry = &db->query_stats[db->query_stats_count];
+    memset(entry, 0, sizeof(DbQueryStats));
+    entry->sql = strdup(sql);
+    if (!entry->sql) {
+        return NULL;
+    }
+    
+    db->query_stats_last = db->query_stats_count++;
+    return entry;
+}
+
+static long long monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/* Elapsed time since the statement's first step, or SQLite's estimate */
+static unsigned long long trace_elapsed_ns(Database *db, sqlite3_stmt *stmt, unsigned long long fallback) {
+    for (int i = 0; i < db->trace_inflight_count; i++) {
+        if (db->trace_inflight[i].stmt == stmt) {
+            long long elapsed = monotonic_ns() - db->trace_inflight[i].start_ns;
+            db->trace_inflight[i] = db->trace_inflight[--db->trace_inflight_count];
+            return (unsigned long long)elapsed;
+        }
+    }
+    return fallback;
+}
+
+static int on_trace(unsigned type, void *ctx, void *p, void *x) {
+    Database *db = ctx;
+    sqlite3_stmt *stmt = p;
+    
+    if (type == SQLITE_TRACE_STMT) {
+        // Also fires for each trigger program of an already running statement
+        for (int i = 0; i < db->trace_inflight_count; i++) {
+            if (db->trace_inflight[i].stmt == stmt) {
+                return 0;
+            }
+        }
+        if (db->trace_inflight_count < DB_TRACE_INFLIGHT) {
+            db->trace_inflight[db->trace_inflight_count].stmt = stmt;
+            db->trace_inflight[db->trace_inflight_count].start_ns = monotonic_ns();
+            db->trace_inflight_count++;
+        }
+        return 0;
+    }
+    
+    const char *sql = sqlite3_sql(stmt);
+    DbQueryStats *stats = sql ? trace_stats_for(db, sql) : NULL;
+    if (!stats) {
+        return 0;
+    }
+    
+    if (type == SQLITE_TRACE_ROW) {
+        stats->rows++;
+        return 0;
+    }
+    
+    // SQLITE_TRACE_PROFILE: x points to SQLite's run time estimate
+    unsigned long long ns = trace_elapsed_ns(db, stmt, *(sqlite3_uint64 *)x);
+    stats->calls++;
+    stats->total_ns += ns;
+    if (ns > stats->max_ns) {
+        stats->max_ns = ns;
+    }
+    
+    int bucket = 0;
+    for (unsigned long long us = ns / 1000; us > 1 && bucket < DB_TRACE_BUCKETS - 1; us >>= 1) {
+        bucket++;
+    }
+    stats->histogram[bucket]++;
+    
+    if (db->slow_query_ns >= 0 && (long long)ns >= db->slow_query_ns) {
+        char *expanded = sqlite3_expanded_sql(stmt);
+        fprintf(stderr, "Slow query (%.1f ms): %s\n", ns / 1e6, expanded ? expanded : sql);
+        sqlite3_free(expanded);
+    }
+    
+    return 0;
+}
+
+BnError db_trace_enable(Database *db, int slow_query_ms) {
+    if (!db || !db->handle) {
+        return BN_ERROR_INVALID_ARG;
+    }
+    
+    unsigned mask = SQLITE_TRACE_STMT | SQLITE_TRACE_PROFILE | SQLITE_TRACE_ROW;
+    if (sqlite3_trace_v2(db->handle, mask, on_trace, db) != SQLITE_OK) {
+        return BN_ERROR_DATABASE;
+    }
+    
+    db->tracing = 1;
+    db->slow_query_ns = slow_query_ms >= 0 ? (long long)slow_query_ms * 1000000 : -1;
+    return BN_SUCCESS;
+}
+
+void db_trace_disable(Database *db) {
+    if (!db || !db->tracing) {
+        return;
+    }
+    
+    sqlite3_trace_v2(db->handle, 0, NULL, NULL);
+    
+    for (int i = 0; i < db->query_stats_count; i++) {
+        free(db->query_stats[i].sql);
+    }
+    free(db->query_stats);
+    db->query_stats = NULL;
+    db->query_stats_count = 0;
+    db->query_stats_capacity = 0;
+    db->query_stats_last = 0;
+    db->trace_inflight_count = 0;
+    db->tracing = 0;
+}
+
+static int compare_stats_total(const void *a, const void *b) {
+    const DbQueryStats *sa = *(const DbQueryStats * const *)a;
+    const DbQueryStats *sb = *(const DbQueryStats * const *)b;
+    if (sa->total_ns != sb->total_ns) {
+        return sa->total_ns < sb->total_ns ? 1 : -1;
+    }
+    return 0;
+}
+
+/* Upper bound of the histogram bucket holding the given fraction of calls, in ms */
+static double stats_percentile_ms(const DbQueryStats *stats, double fraction) {
+    unsigned long target = (unsigned long)(stats->calls * fraction + 0.5);
+    unsigned long seen = 0;
+    
+    if (target == 0) {
+        target = 1;
+    }
+    
+    for (int i = 0; i < DB_TRACE_BUCKETS; i++) {
+        seen += stats->histogram[i];
+        if (seen >= target) {
+            double upper_ms = (double)(2ULL << i) / 1000.0;
+            double max_ms = stats->max_ns / 1e6;
+            return upper_ms < max_ms ? upper_ms : max_ms;
+        }
+    }
+    return stats->max_ns / 1e6;
+}
+
+void db_trace_report(const Database *db, FILE *out) {
+    if (!db || !out) {
+        return;
+    }
+    
+    if (!db->tracing || db->query_stats_count == 0) {
+        fprintf(out, "No queries traced.\n");
+        return;
+    }
+    
+    const DbQueryStats **sorted = malloc(db->query_stats_count * sizeof(DbQueryStats *));
+    if (!sorted) {
+        return;
+    }
+    
+    unsigned long total_calls = 0;
+    unsigned long long total_ns = 0;
+    for (int i = 0; i < db->query_stats_count; i++) {
+        sorted[i] = &db->query_stats[i];
+        total_calls += db->query_stats[i].calls;
+        total_ns += db->query_stats[i].total_ns;
+    }
+    qsort(sorted, db->query_stats_count, sizeof(DbQueryStats *), compare_stats_total);
+    
+    fprintf(out, "\n=== Query statistics ===\n");
+    fprintf(out, "%d statement(s), %lu call(s), %.2f ms total\n\n",
+            db->query_stats_count, total_calls, total_ns / 1e6);
+    fprintf(out, "%7s %10s %9s %9s %9s %9s %9s %9s  %s\n",
+            "calls", "total ms", "avg ms", "p50 ms", "p95 ms", "p99 ms", "max ms", "rows", "statement");
+    
+    for (int i = 0; i < db->query_stats_count; i++) {
+        const DbQueryStats *stats = sorted[i];
+        if (stats->calls == 0) {
+            continue;
+        }
+        
+        // One line per statement: collapse whitespace, cut long SQL
+        char sql[64];
+        size_t len = 0;
+        int space = 0;
+        const char *c = stats->sql;
+        for (; *c && len < sizeof(sql) - 1; c++) {
+            if (*c == ' ' || *c == '\n' || *c == '\t' || *c == '\r') {
+                space = len > 0;
+                continue;
+            }
+            if (space && len < sizeof(sql) - 2) {
+                sql[len++] = ' ';
+            }
+            space = 0;
+            sql[len++] = *c;
+        }
+        sql[len] = '\0';
+        
+        fprintf(out, "%7lu %10.2f %9.3f %9.3f %9.3f %9.3f %9.3f %9llu  %s%s\n",
+                stats->calls,
+                stats->total_ns / 1e6,
+                stats->total_ns / 1e6 / stats->calls,
+                stats_percentile_ms(stats, 0.50),
+                stats_percentile_ms(stats, 0.95),
+                stats_percentile_ms(stats, 0.99),
+                stats->max_ns / 1e6,
+                stats->rows,
+                sql,
+                *c ? "..." : "");
+    }
+    
+    free(sorted);
+}
+
+/* ============================================================================
+ * Change feed
+ * ========================================================================= */
+
+#define CHANGE_QUEUE_INITIAL_CAPACITY 16
+#define CHANGE_QUEUE_MAX 1024      // Beyond this, collapse into RELOAD events
+
+static void change_notify(Database *db, const DbChange *change) {
+    for (int i = 0; i < db->change_subscriber_count; i++) {
+        db->change_subscribers[i].callback(change, db->change_subscribers[i].user_data);
+    }
+}
+
+static void change_dispatch(Database *db) {
+    // Detach the queue first: callbacks may run statements that dispatch again
+    DbChange *queue = db->change_queue;
+    int count = db->change_queue_count;
+    int overflow = db->change_queue_overflow;
+    db->change_queue = NULL;
+    db->change_queue_count = 0;
+    db->change_queue_capacity = 0;
+    db->change_queue_overflow = 0;
+    
+    for (int i = 0; i < count; i++) {
+        if (!(overflow & (1 << queue[i].table))) {
+            change_notify(db, &queue[i]);
+        }
+    }
+    for (int table = DB_TABLE_BOOKS; table <= DB_TABLE_NOTES; table++) {
+        if (overflow & (1 << table)) {
+            DbChange reload = { DB_CHANGE_RELOAD, (DbTable)table, 0 };
+            change_notify(db, &reload);
+        }
+    }
+    
+    free(queue);
+}
+
+static void on_update_hook(void *data, int op, const char *db_name, const char *table_name,
+                           sqlite3_int64 rowid) {
+    Database *db = data;
+    
+    // FTS shadow tables, metadata, attached databases... are not reported
+    DbTable table;
+    if (strcmp(db_name, "main") != 0) {
+        return;
+    } else if (strcmp(table_name, "books") == 0) {
+        table = DB_TABLE_BOOKS;
+    } else if (strcmp(table_name, "notes") == 0) {
+        table = DB_TABLE_NOTES;
+    } else {
+        return;
+    }
+    
+    if (db->change_queue_overflow & (1 << table)) {
+        return;
+    }
+    
+    if (db->change_queue_count == db->change_queue_capacity) {
+        int capacity = db->change_queue_capacity ? db->change_queue_capacity * 2 : CHANGE_QUEUE_INITIAL_CAPACITY;
+        DbChange *queue = capacity <= CHANGE_QUEUE_MAX ?
+            realloc(db->change_queue, capacity * sizeof(DbChange)) : NULL;
+        if (!queue) {
+            // Too many rows (or no memory) to track individually
+            db->change_queue_overflow |= 1 << table;
+            return;
+        }
+        db->change_queue = queue;
+        db->change_queue_capacity = capacity;
+    }
+    
+    DbChange *change = &db->change_queue[db->change_queue_count++];
+    change->kind = op == SQLITE_INSERT ? DB_CHANGE_INSERT :
+                   op == SQLITE_DELETE ? DB_CHANGE_DELETE : DB_CHANGE_UPDATE;
+    change->table = table;
+    change->rowid = rowid;
+}
+
+static void on_rollback_hook(void *data) {
+    Database *db = data;
+    db->change_queue_count = 0;
+    db->change_queue_overflow = 0;
+}
+
+static BnError read_data_version(Database *db, long long *out_version) {
+    sqlite3_stmt *stmt;
+    BnError err = db_stmt_acquire(db, "PRAGMA data_version;", &stmt);
+    if (err != BN_SUCCESS) {
+        return err;
+    }
+    
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        *out_version = sqlite3_column_int64(stmt, 0);
+    } else {
+        err = BN_ERROR_DATABASE;
+    }
+    
+    db_stmt_release(db, stmt);
+    return err;
+}
+
+BnError db_change_subscribe(Database *db, DbChangeCallback callback, void *user_data) {
+    if (!db || !db->handle || !callback) {
+        return BN_ERROR_INVALID_ARG;
+    }
+    
+    DbChangeSubscriber *subscribers = realloc(db->change_subscribers,
+        (db->change_subscriber_count + 1) * sizeof(DbChangeSubscriber));
+    if (!subscribers) {
+        return BN_ERROR_OUT_OF_MEMORY;
+    }
+    db->change_subscribers = subscribers;
+    
+    // Hooks are only installed while someone listens
+    if (db->change_subscriber_count == 0) {
+        BnError err = read_data_version(db, &db->data_version);
+        if (err != BN_SUCCESS) {
+            return err;
+        }
+        sqlite3_update_hook(db->handle, on_update_hook, db);
+        sqlite3_rollback_hook(db->handle, on_rollback_hook, db);
+    }
+    
+    subscribers[db->change_subscriber_count].callback = callback;
+    subscribers[db->change_subscriber_count].user_data = user_data;
+    db->change_subscriber_count++;
+    return BN_SUCCESS;
+}
+
+void db_change_unsubscribe(Database *db, DbChangeCallback callback, void *user_data) {
+    if (!db) {
+        return;
+    }
+    
+    for (int i = 0; i < db->change_subscriber_count; i++) {
+        if (db->change_subscribers[i].callback == callback &&
+            db->change_subscribers[i].user_data == user_data) {
+            memmove(&db->change_subscribers[i], &db->change_subscribers[i + 1],
+                    (db->change_subscriber_count - i - 1) * sizeof(DbChangeSubscriber));
+            db->change_subscriber_count--;
+            break;
+        }
+    }
+    
+    if (db->change_subscriber_count == 0 && db->handle) {
+        sqlite3_update_hook(db->handle, NULL, NULL);
+        sqlite3_rollback_hook(db->handle, NULL, NULL);
+        db->change_queue_count = 0;
+        db->change_queue_overflow = 0;
+    }
+}
+
+BnError db_change_poll(Database *db, int *out_changed) {
+    if (!db || !db->handle) {
+        return BN_ERROR_INVALID_ARG;
+    }
+    
+    long long version = 0;
+    BnError err = read_data_version(db, &version);
+    if (err != BN_SUCCESS) {
+        return err;
+    }
+    
+    int changed = version != db->data_version;
+    db->data_version = version;
+    
+    if (changed) {
+        for (int table = DB_TABLE_BOOKS; table <= DB_TABLE_NOTES; table++) {
+            DbChange reload = { DB_CHANGE_RELOAD, (DbTable)table, 0 };
+            change_notify(db, &reload);
+        }
+    }
+    
+    if (out_changed) {
+        *out_changed = changed;
+    }
+    return BN_SUCCESS;
+}
+
+void db_change_forward(Database *db, const DbChange *changes, int count) {
+    if (!db || !db->handle || (!changes && count > 0)) {
+        return;
+    }
+    
+    for (int i = 0; i < count; i++) {
+        change_notify(db, &changes[i]);
+    }
+    
+    // A commit by a third process in between is missed until its next one
+    if (db->change_subscriber_count > 0) {
+        read_data_version(db, &db->data_version);
+    }
+}
+
 BnError db_begin_transaction(Database *db) {
     if (!db || !db->handle) {
         return BN_ERROR_INVALID_ARG;
@@ -176,6 +871,10 @@ BnError db_commit_transaction(Database *db) {
         return BN_ERROR_DATABASE;
     }
     
+    if (db->change_queue_count > 0 || db->change_queue_overflow) {
+        change_dispatch(db);
+    }
+    
     return BN_SUCCESS;
 }
 
@@ -196,3 +895,174 @@ BnError db_rollback_transaction(Database *db) {
     
     return BN_SUCCESS;
 }
+
+/* ============================================================================
+ * Backup and restore
+ * ========================================================================= */
+
+#define BACKUP_STEP_PAGES 1024     // 4 MiB with the default page size
+#define BACKUP_RETRY_MS 20
+
+/* Copy src into dest a few pages at a time, so src is only locked per step */
+static BnError backup_copy(sqlite3 *dest, sqlite3 *src, DbBackupProgress progress, void *user_data) {
+    sqlite3_stmt *stmt;
+    long long page_size = 4096;
+    if (sqlite3_prepare_v2(src, "PRAGMA page_size;", -1, &stmt, NULL) == SQLITE_OK) {
+        if (sqlite3_step(stmt) == SQLITE_ROW) {
+            page_size = sqlite3_column_int64(stmt, 0);
+        }
+        sqlite3_finalize(stmt);
+    }
+    
+    sqlite3_backup *backup = sqlite3_backup_init(dest, "main", src, "main");
+    if (!backup) {
+        return BN_ERROR_DATABASE;
+    }
+    
+    int rc;
+    do {
+        rc = sqlite3_backup_step(backup, BACKUP_STEP_PAGES);
+        
+        if (progress && (rc == SQLITE_OK || rc == SQLITE_DONE)) {
+            long long total = sqlite3_backup_pagecount(backup);
+            long long done = total - sqlite3_backup_remaining(backup);
+            progress(done * page_size, total * page_size, user_data);
+        }
+        
+        // Another connection holds the lock: let it finish, then go on
+        if (rc == SQLITE_BUSY || rc == SQLITE_LOCKED) {
+            sqlite3_sleep(BACKUP_RETRY_MS);
+        }
+    } while (rc == SQLITE_OK || rc == SQLITE_BUSY || rc == SQLITE_LOCKED);
+    
+    int finish_rc = sqlite3_backup_finish(backup);
+    if (rc != SQLITE_DONE || finish_rc != SQLITE_OK) {
+        return BN_ERROR_DATABASE;
+    }
+    
+    return BN_SUCCESS;
+}
+
+BnError db_backup_to(Database *db, const char *path, DbBackupProgress progress, void *user_data) {
+    if (!db || !db->handle || !path) {
+        return BN_ERROR_INVALID_ARG;
+    }
+    
+    // Build the copy next to the target and move it into place when complete
+    size_t len = strlen(path) + sizeof(".partial");
+    char *partial = malloc(len);
+    if (!partial) {
+        return BN_ERROR_OUT_OF_MEMORY;
+    }
+    snprintf(partial, len, "%s.partial", path);
+    unlink(partial);
+    
+    sqlite3 *dest = NULL;
+    BnError err = BN_SUCCESS;
+    if (sqlite3_open_v2(partial, &dest, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, NULL) != SQLITE_OK) {
+        err = BN_ERROR_PERMISSION;
+    }
+    
+    // In WAL mode a read transaction does not block writers, so hold one
+    // for the whole copy: every step then reads the same snapshot and
+    // commits by other connections no longer restart the backup
+    int snapshot = 0;
+    if (err == BN_SUCCESS && sqlite3_get_autocommit(db->handle)) {
+        sqlite3_stmt *stmt;
+        if (sqlite3_prepare_v2(db->handle, "PRAGMA journal_mode;", -1, &stmt, NULL) == SQLITE_OK) {
+            snapshot = sqlite3_step(stmt) == SQLITE_ROW &&
+                       strcmp((const char *)sqlite3_column_text(stmt, 0), "wal") == 0;
+            sqlite3_finalize(stmt);
+        }
+        if (snapshot) {
+            snapshot = sqlite3_exec(db->handle, "BEGIN; SELECT count(*) FROM sqlite_master;",
+                                    NULL, NULL, NULL) == SQLITE_OK;
+        }
+    }
+    
+    if (err == BN_SUCCESS) {
+        err = backup_copy(dest, db->handle, progress, user_data);
+    }
+    if (snapshot) {
+        sqlite3_exec(db->handle, "COMMIT;", NULL, NULL, NULL);
+    }
+    
+    // A backup of a WAL database is in WAL mode too; make it a single file
+    if (err == BN_SUCCESS &&
+        sqlite3_exec(dest, "PRAGMA journal_mode = DELETE;", NULL, NULL, NULL) != SQLITE_OK) {
+        err = BN_ERROR_DATABASE;
+    }
+    
+    sqlite3_close(dest);
+    
+    if (err == BN_SUCCESS && rename(partial, path) != 0) {
+        err = BN_ERROR_PERMISSION;
+    }
+    if (err != BN_SUCCESS) {
+        unlink(partial);
+    }
+    
+    free(partial);
+    return err;
+}
+
+BnError db_restore_from(Database *db, const char *path, DbBackupProgress progress, void *user_data) {
+    if (!db || !db->handle || !path) {
+        return BN_ERROR_INVALID_ARG;
+    }
+    
+    // The cache is cleared below; a checked-out statement would be finalized under its holder
+    for (int i = 0; i < db->stmt_cache_count; i++) {
+        if (db->stmt_cache[i].in_use) {
+            return BN_ERROR_BUSY;
+        }
+    }
+    
+    sqlite3 *src = NULL;
+    if (sqlite3_open_v2(path, &src, SQLITE_OPEN_READONLY, NULL) != SQLITE_OK) {
+        sqlite3_close(src);
+        return BN_ERROR_FILE_NOT_FOUND;
+    }
+    
+    // Only take booknote databases this version can migrate (backups made
+    // before user_version was set have a books table and version 0)
+    int version = 0;
+    BnError err = schema_get_version(src, &version);
+    if (err == BN_ERROR_NOT_FOUND) {
+        int exists = 0;
+        err = schema_has_table(src, "books", &exists);
+        if (err == BN_SUCCESS && !exists) {
+            err = BN_ERROR_INVALID_ARG;
+        }
+    } else if (err == BN_ERROR_DATABASE || (err == BN_SUCCESS && version > SCHEMA_VERSION)) {
+        err = BN_ERROR_INVALID_ARG;
+    }
+    
+    if (err == BN_SUCCESS) {
+        // Statements prepared against the old contents must not outlive them
+        stmt_cache_clear(db);
+        err = backup_copy(db->handle, src, progress, user_data);
+    }
+    sqlite3_close(src);
+    
+    if (err != BN_SUCCESS) {
+        return err;
+    }
+    
+    // An older backup is brought up to the current schema
+    err = schema_initialize(db->handle);
+    if (err != BN_SUCCESS) {
+        return err;
+    }
+    
+    // Every row may have changed
+    for (int table = DB_TABLE_BOOKS; table <= DB_TABLE_NOTES; table++) {
+        DbChange reload = { DB_CHANGE_RELOAD, (DbTable)table, 0 };
+        change_notify(db, &reload);
+    }
+    if (db->change_subscriber_count > 0) {
+        read_data_version(db, &db->data_version);
+    }
+    
+    return BN_SUCCESS;
+}
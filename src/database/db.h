@@ -1,21 +1,172 @@
 #ifndef BOOKNOTE_DB_H
 #define BOOKNOTE_DB_H
 
+#include <stdio.h>
 #include <sqlite3.h>
 #include "../utils/error.h"
 
+/**
+ * Prepared statement cache entry
+ * Keyed by the SQL text; the statement is reset and rebound on reuse
+ */
+typedef struct {
+    char *sql;              // Query text (cache key)
+    sqlite3_stmt *stmt;     // Prepared statement
+    int in_use;             // Non-zero while checked out by a caller
+} DbCachedStmt;
+
+/**
+ * Latency histogram buckets: bucket i counts statements that took
+ * [2^i, 2^(i+1)) microseconds; the last bucket also holds anything slower
+ */
+#define DB_TRACE_BUCKETS 24
+
+/**
+ * Statements timed concurrently while tracing (open cursors nest)
+ */
+#define DB_TRACE_INFLIGHT 16
+
+/**
+ * Start time of a running statement
+ */
+typedef struct {
+    sqlite3_stmt *stmt;
+    long long start_ns;
+} DbTraceInflight;
+
+/**
+ * Per-statement counters collected while tracing (see db_trace_enable)
+ * Keyed by the SQL text, so every execution of a cached statement and of
+ * its private copies adds up in one entry.
+ */
+typedef struct {
+    char *sql;
+    unsigned long calls;
+    unsigned long long rows;            // Result rows returned
+    unsigned long long total_ns;
+    unsigned long long max_ns;
+    unsigned long histogram[DB_TRACE_BUCKETS];
+} DbQueryStats;
+
+/**
+ * Tables reported by the change feed
+ */
+typedef enum {
+    DB_TABLE_BOOKS = 0,
+    DB_TABLE_NOTES
+} DbTable;
+
+/**
+ * Kind of change
+ */
+typedef enum {
+    DB_CHANGE_INSERT = 0,
+    DB_CHANGE_UPDATE,
+    DB_CHANGE_DELETE,
+    DB_CHANGE_RELOAD        // Unknown set of rows changed (another process, bulk write)
+} DbChangeKind;
+
+/**
+ * Row change event
+ */
+typedef struct {
+    DbChangeKind kind;
+    DbTable table;
+    long long rowid;        // Row id (0 for DB_CHANGE_RELOAD)
+} DbChange;
+
+/**
+ * Change feed callback
+ */
+typedef void (*DbChangeCallback)(const DbChange *change, void *user_data);
+
+/**
+ * Change feed subscriber
+ */
+typedef struct {
+    DbChangeCallback callback;
+    void *user_data;
+} DbChangeSubscriber;
+
 /**
  * Database context
+ * A connection is not thread-safe: its statement cache and change feed
+ * assume one thread at a time. Threads either open their own or check one
+ * out of a DbPool (see pool.h).
  */
 typedef struct {
     sqlite3 *handle;
     char *path;
+
+    // Prepared statement cache (see db_stmt_acquire)
+    DbCachedStmt *stmt_cache;
+    int stmt_cache_count;
+    int stmt_cache_capacity;
+    unsigned long stmt_cache_hits;
+    unsigned long stmt_cache_misses;
+
+    // Change feed (see db_change_subscribe)
+    DbChangeSubscriber *change_subscribers;
+    int change_subscriber_count;
+    DbChange *change_queue;         // Events of the transaction in progress
+    int change_queue_count;
+    int change_queue_capacity;
+    int change_queue_overflow;      // Bitmask of tables whose events were collapsed
+    long long data_version;         // Last PRAGMA data_version seen by db_change_poll
+
+    // Query tracing (see db_trace_enable)
+    int tracing;
+    long long slow_query_ns;        // Log statements at least this slow (-1 disables)
+    DbQueryStats *query_stats;
+    int query_stats_count;
+    int query_stats_capacity;
+    int query_stats_last;           // Entry hit by the previous event
+    DbTraceInflight trace_inflight[DB_TRACE_INFLIGHT];
+    int trace_inflight_count;
 } Database;
 
+/**
+ * Connection performance profiles
+ */
+typedef enum {
+    DB_PROFILE_FAST = 0,    // WAL journal, synchronous=NORMAL (default)
+    DB_PROFILE_DURABLE      // Rollback journal, synchronous=FULL (pre-WAL behavior)
+} DbProfile;
+
+/**
+ * Connection options applied by db_open_ex
+ * Start from db_options_init and override individual fields
+ */
+typedef struct {
+    const char *journal_mode;   // "WAL", "DELETE", ... (NULL keeps SQLite's default)
+    const char *synchronous;    // "OFF", "NORMAL", "FULL" (NULL keeps SQLite's default)
+    long long mmap_size;        // Bytes of the file to memory-map (0 disables)
+    int cache_size_kib;         // Page cache size in KiB (0 keeps SQLite's default)
+    int temp_store_memory;      // Non-zero keeps temp tables and indices in memory
+    int busy_timeout_ms;        // Wait this long on a locked database (0 fails immediately)
+    int read_only;              // Open an existing database read-only (no schema setup)
+    int trace_queries;          // Collect per-statement statistics (db_trace_enable)
+    int slow_query_ms;          // Log slower statements to stderr (-1 disables, implies tracing)
+} DbOptions;
+
+/**
+ * Fill options with the settings of a profile
+ */
+void db_options_init(DbOptions *opts, DbProfile profile);
+
+/**
+ * Fill options with the profile db_open uses
+ * DB_PROFILE_DURABLE when BOOKNOTE_DB_PROFILE is "durable", else DB_PROFILE_FAST.
+ * BOOKNOTE_TRACE_QUERIES=1 turns on query tracing and
+ * BOOKNOTE_SLOW_QUERY_MS=N logs statements taking N ms or more.
+ */
+void db_options_default(DbOptions *opts);
+
 /**
  * Initialize and open database
  * Creates database file if it doesn't exist
  * Initializes schema if needed
+ * Registers the word_count(text) SQL function used by the statistics queries
  * 
  * @param out_db Pointer to store database context
  * @param path Path to database file (NULL for default location)
@@ -23,6 +174,17 @@ typedef struct {
  */
 BnError db_open(Database **out_db, const char *path);
 
+/**
+ * Open database with explicit connection options
+ * db_open uses the options of db_options_default.
+ * 
+ * @param out_db Pointer to store database context
+ * @param path Path to database file (NULL for default location)
+ * @param opts Connection options (NULL for the default profile)
+ * @return BN_SUCCESS on success, error code otherwise
+ */
+BnError db_open_ex(Database **out_db, const char *path, const DbOptions *opts);
+
 /**
  * Close database connection
  */
@@ -37,6 +199,127 @@ void db_close(Database *db);
  */
 BnError db_get_default_path(char **out_path);
 
+/**
+ * Get a prepared statement for the given SQL from the connection's cache
+ * Prepares and caches the statement on first use. If the cached statement
+ * is already checked out (e.g. an open cursor), a private statement is
+ * prepared instead and finalized on release.
+ * 
+ * @param db Database context
+ * @param sql SQL text (used as cache key)
+ * @param out_stmt Pointer to store the statement (must be given back with db_stmt_release)
+ * @return BN_SUCCESS on success, error code otherwise
+ */
+BnError db_stmt_acquire(Database *db, const char *sql, sqlite3_stmt **out_stmt);
+
+/**
+ * Return a statement obtained from db_stmt_acquire
+ * Resets the statement and clears its bindings so it can be reused
+ */
+void db_stmt_release(Database *db, sqlite3_stmt *stmt);
+
+/**
+ * Get statement cache hit/miss counters
+ */
+void db_stmt_cache_stats(const Database *db, unsigned long *out_hits, unsigned long *out_misses);
+
+/**
+ * Change feed
+ * 
+ * Subscribers receive one event per inserted, updated or deleted row of
+ * books and notes, after the write is committed: when the statement that
+ * made it is released (autocommit) or from db_commit_transaction. Events
+ * of a rolled back transaction are dropped. Very large transactions are
+ * collapsed into a single DB_CHANGE_RELOAD per table.
+ * 
+ * Callbacks may query the database, but must not unsubscribe. An INSERT
+ * or UPDATE event can refer to a row that no longer exists (e.g. a row
+ * rejected by a foreign key check); treat that like a delete.
+ */
+
+/**
+ * Subscribe to row changes
+ */
+BnError db_change_subscribe(Database *db, DbChangeCallback callback, void *user_data);
+
+/**
+ * Remove a subscription added with db_change_subscribe
+ */
+void db_change_unsubscribe(Database *db, DbChangeCallback callback, void *user_data);
+
+/**
+ * Check for changes committed by other connections or processes
+ * Uses PRAGMA data_version; when it moved, subscribers get a
+ * DB_CHANGE_RELOAD for every table since the individual rows are unknown.
+ * 
+ * @param out_changed Optional pointer set to 1 if anything changed
+ */
+BnError db_change_poll(Database *db, int *out_changed);
+
+/**
+ * Deliver changes committed through another connection to this one's
+ * subscribers (e.g. the events of a worker thread's connection)
+ * Those commits are also marked as seen, so db_change_poll does not turn
+ * them into a reload.
+ */
+void db_change_forward(Database *db, const DbChange *changes, int count);
+
+/**
+ * Start collecting per-statement call counts, latencies and row counts
+ * Uses sqlite3_trace_v2, so every statement on the connection is covered,
+ * including sqlite3_exec and the internal queries of FTS5. Statements are
+ * timed with a monotonic clock from first step to completion (SQLite's own
+ * profile time only has millisecond resolution on Unix).
+ * 
+ * @param slow_query_ms Print statements taking at least this long to
+ *                      stderr with their bound values (-1 disables)
+ */
+BnError db_trace_enable(Database *db, int slow_query_ms);
+
+/**
+ * Stop tracing and discard the collected statistics
+ */
+void db_trace_disable(Database *db);
+
+/**
+ * Print the collected statistics, slowest total first
+ * Percentiles come from the histogram and are bucket upper bounds.
+ */
+void db_trace_report(const Database *db, FILE *out);
+
+/**
+ * Backup progress callback
+ * Called after each step with the bytes copied so far and the total.
+ */
+typedef void (*DbBackupProgress)(long long done_bytes, long long total_bytes, void *user_data);
+
+/**
+ * Write a consistent copy of the database to path while it stays in use
+ * Uses the SQLite backup API a few MiB at a time. With the WAL journal
+ * the copy reads one snapshot and never blocks writers; otherwise other
+ * connections can write between steps, but each such write restarts the
+ * copy. It is built in "<path>.partial" and renamed when complete.
+ * 
+ * @param path Destination file (replaced if it exists)
+ * @param progress Optional progress callback
+ * @return BN_SUCCESS on success, error code otherwise
+ */
+BnError db_backup_to(Database *db, const char *path, DbBackupProgress progress, void *user_data);
+
+/**
+ * Replace the contents of the database with a backup
+ * The backup must be a booknote database no newer than this version; an
+ * older one is migrated afterwards. Subscribers get a DB_CHANGE_RELOAD
+ * for every table.
+ * 
+ * @param path Backup file to read
+ * @param progress Optional progress callback
+ * @return BN_SUCCESS on success, BN_ERROR_INVALID_ARG if path is not a
+ *         usable booknote database, BN_ERROR_BUSY while a statement from
+ *         db_stmt_acquire is still held, error code otherwise
+ */
+BnError db_restore_from(Database *db, const char *path, DbBackupProgress progress, void *user_data);
+
 /**
  * Begin transaction
  */
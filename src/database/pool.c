@@ -0,0 +1,135 @@
+#define _POSIX_C_SOURCE 200809L
+#include "pool.h"
+#include <pthread.h>
+#include <stdlib.h>
+
+struct DbPool {
+    pthread_mutex_t lock;
+    pthread_cond_t released;        // Signalled whenever a connection comes back
+
+    Database *writer;
+    int writer_busy;
+
+    Database **readers;
+    int *reader_busy;
+    int reader_count;
+};
+
+BnError db_pool_open(DbPool **out_pool, const char *path, int readers) {
+    if (!out_pool || readers < 1) {
+        return BN_ERROR_INVALID_ARG;
+    }
+    
+    DbPool *pool = calloc(1, sizeof(DbPool));
+    if (!pool) {
+        return BN_ERROR_OUT_OF_MEMORY;
+    }
+    
+    pool->readers = calloc(readers, sizeof(Database *));
+    pool->reader_busy = calloc(readers, sizeof(int));
+    if (!pool->readers || !pool->reader_busy) {
+        free(pool->readers);
+        free(pool->reader_busy);
+        free(pool);
+        return BN_ERROR_OUT_OF_MEMORY;
+    }
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->released, NULL);
+    
+    DbOptions opts;
+    db_options_default(&opts);
+    
+    BnError err = db_open_ex(&pool->writer, path, &opts);
+    if (err != BN_SUCCESS) {
+        db_pool_close(pool);
+        return err;
+    }
+    
+    // Readers open the file the writer resolved (path may be NULL)
+    opts.read_only = 1;
+    for (int i = 0; i < readers; i++) {
+        err = db_open_ex(&pool->readers[i], pool->writer->path, &opts);
+        if (err != BN_SUCCESS) {
+            db_pool_close(pool);
+            return err;
+        }
+        pool->reader_count++;
+    }
+    
+    *out_pool = pool;
+    return BN_SUCCESS;
+}
+
+BnError db_pool_acquire_reader(DbPool *pool, Database **out_db) {
+    if (!pool || !out_db) {
+        return BN_ERROR_INVALID_ARG;
+    }
+    
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        for (int i = 0; i < pool->reader_count; i++) {
+            if (!pool->reader_busy[i]) {
+                pool->reader_busy[i] = 1;
+                *out_db = pool->readers[i];
+                pthread_mutex_unlock(&pool->lock);
+                return BN_SUCCESS;
+            }
+        }
+        pthread_cond_wait(&pool->released, &pool->lock);
+    }
+}
+
+BnError db_pool_acquire_writer(DbPool *pool, Database **out_db) {
+    if (!pool || !out_db) {
+        return BN_ERROR_INVALID_ARG;
+    }
+    
+    pthread_mutex_lock(&pool->lock);
+    while (pool->writer_busy) {
+        pthread_cond_wait(&pool->released, &pool->lock);
+    }
+    pool->writer_busy = 1;
+    *out_db = pool->writer;
+    pthread_mutex_unlock(&pool->lock);
+    
+    return BN_SUCCESS;
+}
+
+void db_pool_release(DbPool *pool, Database *db) {
+    if (!pool || !db) {
+        return;
+    }
+    
+    pthread_mutex_lock(&pool->lock);
+    if (db == pool->writer) {
+        pool->writer_busy = 0;
+    } else {
+        for (int i = 0; i < pool->reader_count; i++) {
+            if (pool->readers[i] == db) {
+                pool->reader_busy[i] = 0;
+                break;
+            }
+        }
+    }
+    // Readers and writer waiters share the condition, so wake them all
+    pthread_cond_broadcast(&pool->released);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void db_pool_close(DbPool *pool) {
+    if (!pool) {
+        return;
+    }
+    
+    for (int i = 0; i < pool->reader_count; i++) {
+        db_close(pool->readers[i]);
+    }
+    // Closed last: its connection may checkpoint the WAL on the way out
+    db_close(pool->writer);
+    
+    pthread_cond_destroy(&pool->released);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->readers);
+    free(pool->reader_busy);
+    free(pool);
+}
@@ -0,0 +1,57 @@
+#ifndef BOOKNOTE_POOL_H
+#define BOOKNOTE_POOL_H
+
+#include "db.h"
+
+/**
+ * Connection pool: one writer and N read-only readers on the same file
+ *
+ * With the WAL journal (the default profile) readers see the last
+ * committed state and never wait for the writer, so background jobs can
+ * scan or search while the UI saves notes. Under the durable profile the
+ * pool still works, but readers and the writer lock each other out.
+ *
+ * Each checked-out connection belongs to the calling thread until it is
+ * released. On a reader, only the read functions of queries.h may be
+ * used: the get, page, count, search, cursor and size functions. Inserts,
+ * updates, deletes, imports and index maintenance need the writer and
+ * fail with BN_ERROR_DATABASE on a reader.
+ */
+typedef struct DbPool DbPool;
+
+/**
+ * Open a pool
+ * The writer is opened first (creating and migrating the schema), then
+ * the readers with the same profile in read-only mode.
+ *
+ * @param out_pool Pointer to store the pool
+ * @param path Path to database file (NULL for default location)
+ * @param readers Number of reader connections (at least 1)
+ * @return BN_SUCCESS on success, error code otherwise
+ */
+BnError db_pool_open(DbPool **out_pool, const char *path, int readers);
+
+/**
+ * Check out a reader connection
+ * Blocks until one is free.
+ */
+BnError db_pool_acquire_reader(DbPool *pool, Database **out_db);
+
+/**
+ * Check out the writer connection
+ * Blocks until the current holder releases it.
+ */
+BnError db_pool_acquire_writer(DbPool *pool, Database **out_db);
+
+/**
+ * Return a connection obtained from db_pool_acquire_reader/writer
+ */
+void db_pool_release(DbPool *pool, Database *db);
+
+/**
+ * Close every connection and free the pool
+ * All connections must have been released.
+ */
+void db_pool_close(DbPool *pool);
+
+#endif // BOOKNOTE_POOL_H
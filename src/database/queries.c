@@ -1,28 +1,325 @@
 #define _POSIX_C_SOURCE 200809L
 #include "queries.h"
+#include "schema.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <ctype.h>
 
 /* ============================================================================
- * Book operations
+ * Shared SQL
  * ========================================================================= */
 
-BnError db_book_insert(Database *db, Book *book) {
-    if (!db || !db->handle || !book) {
-        return BN_ERROR_INVALID_ARG;
+static const char *SQL_BOOK_INSERT =
+    "INSERT INTO books (isbn, title, author, year, publisher, filepath, cover_path, added_at, updated_at) "
+    "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?);";
+
+static const char *SQL_NOTE_INSERT =
+    "INSERT INTO notes (book_id, title, content, page_number, created_at, updated_at) "
+    "VALUES (?, ?, ?, ?, ?, ?);";
+
+static const char *SQL_BOOK_SELECT_ALL =
+    "SELECT id, isbn, title, author, year, publisher, filepath, cover_path, added_at, updated_at "
+    "FROM books ORDER BY title COLLATE NOCASE, id;";
+
+static const char *SQL_NOTE_SELECT_BY_BOOK =
+    "SELECT id, book_id, title, content, page_number, created_at, updated_at "
+    "FROM notes WHERE book_id = ? ORDER BY created_at, id;";
+
+static const char *SQL_NOTE_SEARCH =
+    "SELECT n.id, n.book_id, n.title, n.content, n.page_number, n.created_at, n.updated_at "
+    "FROM notes n "
+    "JOIN notes_fts fts ON n.id = fts.rowid "
+    "WHERE fts.content MATCH ? "
+    "ORDER BY n.created_at DESC;";
+
+// A negative LIMIT means no limit
+static const char *SQL_NOTE_SEARCH_RANKED =
+    "SELECT n.id, n.book_id, n.page_number, n.title, "
+    "snippet(notes_fts, -1, ?3, ?4, '...', ?5), bm25(notes_fts, ?7, ?2) AS score, b.title "
+    "FROM notes_fts JOIN notes n ON n.id = notes_fts.rowid "
+    "JOIN books b ON b.id = n.book_id "
+    "WHERE notes_fts MATCH ?1 "
+    "ORDER BY score LIMIT ?6;";
+
+static const char *SQL_NOTE_SEARCH_TRIGRAM =
+    "SELECT n.id, n.book_id, n.page_number, n.title, "
+    "snippet(notes_trigram, -1, ?3, ?4, '...', ?5), bm25(notes_trigram, ?7, ?2) AS score, b.title "
+    "FROM notes_trigram JOIN notes n ON n.id = notes_trigram.rowid "
+    "JOIN books b ON b.id = n.book_id "
+    "WHERE notes_trigram MATCH ?1 "
+    "ORDER BY score LIMIT ?6;";
+
+// snippet() repeats text when many overlapping trigram phrases match, so
+// fuzzy hits show the start of the note instead (?3 and ?4 are unused)
+static const char *SQL_NOTE_SEARCH_FUZZY =
+    "SELECT n.id, n.book_id, n.page_number, n.title, "
+    "CASE WHEN length(n.content) > ?5 THEN substr(n.content, 1, ?5) || '...' ELSE n.content END, "
+    "bm25(notes_trigram, ?7, ?2) AS score, b.title "
+    "FROM notes_trigram JOIN notes n ON n.id = notes_trigram.rowid "
+    "JOIN books b ON b.id = n.book_id "
+    "WHERE notes_trigram MATCH ?1 "
+    "ORDER BY score LIMIT ?6;";
+
+// Library search: ORDER BY rank lets FTS5 sort the matches itself and
+// hand them out best first, so snippet() and the joins only run for the
+// rows actually read. ?2 is the rank function, e.g. 'bm25(2.0, 1.0)'
+static const char *SQL_LIBRARY_SEARCH_NOTES =
+    "SELECT n.id, n.book_id, n.page_number, n.title, "
+    "snippet(notes_fts, -1, ?3, ?4, '...', ?5), notes_fts.rank, b.title "
+    "FROM notes_fts JOIN notes n ON n.id = notes_fts.rowid "
+    "JOIN books b ON b.id = n.book_id "
+    "WHERE notes_fts MATCH ?1 AND notes_fts.rank MATCH ?2 "
+    "ORDER BY notes_fts.rank LIMIT ?6;";
+
+static const char *SQL_LIBRARY_SEARCH_PAGES =
+    "SELECT p.book_id, p.page, "
+    "snippet(pdf_pages_fts, 2, ?3, ?4, '...', ?5), pdf_pages_fts.rank, b.title "
+    "FROM pdf_pages_fts JOIN pdf_pages p ON p.id = pdf_pages_fts.rowid "
+    "JOIN books b ON b.id = p.book_id "
+    "WHERE pdf_pages_fts MATCH ?1 AND pdf_pages_fts.rank MATCH ?2 "
+    "ORDER BY pdf_pages_fts.rank LIMIT ?6;";
+
+static const char *SQL_BOOK_SEARCH =
+    "SELECT b.id, b.isbn, b.title, b.author, b.year, b.publisher, b.filepath, b.cover_path, "
+    "b.added_at, b.updated_at "
+    "FROM books_fts JOIN books b ON b.id = books_fts.rowid "
+    "WHERE books_fts MATCH ?1 "
+    "ORDER BY bm25(books_fts, 4.0, 2.0, 1.0, 1.0) LIMIT ?2;";
+
+#define SQL_BOOK_COLUMNS \
+    "SELECT id, isbn, title, author, year, publisher, filepath, cover_path, added_at, updated_at FROM books "
+#define SQL_NOTE_COLUMNS \
+    "SELECT id, book_id, title, content, page_number, created_at, updated_at FROM notes "
+
+/* Keyset pages, indexed by sort key: [first page, page after ?1]. The
+ * anchor row's key is looked up by id so callers only carry an id. */
+static const char *SQL_BOOK_PAGE[][2] = {
+    [BOOK_SORT_TITLE] = {
+        SQL_BOOK_COLUMNS "ORDER BY title COLLATE NOCASE, id LIMIT ?2;",
+        // The scalar bound seeds the index range; the row value breaks title ties
+        SQL_BOOK_COLUMNS "WHERE title COLLATE NOCASE >= (SELECT title FROM books WHERE id = ?1) "
+                         "AND (title COLLATE NOCASE, id) > (SELECT title, id FROM books WHERE id = ?1) "
+                         "ORDER BY title COLLATE NOCASE, id LIMIT ?2;"
+    },
+    [BOOK_SORT_ADDED] = {
+        SQL_BOOK_COLUMNS "ORDER BY id LIMIT ?2;",
+        SQL_BOOK_COLUMNS "WHERE id > ?1 ORDER BY id LIMIT ?2;"
+    }
+};
+
+static const char *SQL_NOTE_PAGE[][2] = {
+    [NOTE_SORT_CREATED] = {
+        SQL_NOTE_COLUMNS "WHERE book_id = ?3 ORDER BY created_at, id LIMIT ?2;",
+        SQL_NOTE_COLUMNS "WHERE book_id = ?3 AND (created_at, id) > "
+                         "(SELECT created_at, id FROM notes WHERE id = ?1) "
+                         "ORDER BY created_at, id LIMIT ?2;"
+    },
+    [NOTE_SORT_PAGE] = {
+        SQL_NOTE_COLUMNS "WHERE book_id = ?3 ORDER BY coalesce(page_number, 0), id LIMIT ?2;",
+        SQL_NOTE_COLUMNS "WHERE book_id = ?3 AND (coalesce(page_number, 0), id) > "
+                         "(SELECT coalesce(page_number, 0), id FROM notes WHERE id = ?1) "
+                         "ORDER BY coalesce(page_number, 0), id LIMIT ?2;"
+    }
+};
+
+/* ============================================================================
+ * Row helpers
+ * ========================================================================= */
+
+#define RESULT_INITIAL_CAPACITY 16
+
+static char *column_strdup(sqlite3_stmt *stmt, int col) {
+    const char *text = (const char *)sqlite3_column_text(stmt, col);
+    return text ? strdup(text) : NULL;
+}
+
+/* Columns: id, isbn, title, author, year, publisher, filepath, cover_path, added_at, updated_at */
+static BnError book_from_row(sqlite3_stmt *stmt, Book **out_book) {
+    Book *book = calloc(1, sizeof(Book));
+    if (!book) {
+        return BN_ERROR_OUT_OF_MEMORY;
     }
     
-    const char *sql = 
-        "INSERT INTO books (isbn, title, author, year, publisher, filepath, cover_path, added_at, updated_at) "
-        "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?);";
+    book->id = sqlite3_column_int(stmt, 0);
+    book->isbn = column_strdup(stmt, 1);
+    book->title = column_strdup(stmt, 2);
+    book->author = column_strdup(stmt, 3);
+    book->year = sqlite3_column_int(stmt, 4);
+    book->publisher = column_strdup(stmt, 5);
+    book->filepath = column_strdup(stmt, 6);
+    book->cover_path = column_strdup(stmt, 7);
+    book->added_at = (time_t)sqlite3_column_int64(stmt, 8);
+    book->updated_at = (time_t)sqlite3_column_int64(stmt, 9);
+    
+    if (!book->title || !book->filepath) {
+        book_free(book);
+        return BN_ERROR_OUT_OF_MEMORY;
+    }
     
-    sqlite3_stmt *stmt;
-    int rc = sqlite3_prepare_v2(db->handle, sql, -1, &stmt, NULL);
-    if (rc != SQLITE_OK) {
-        return BN_ERROR_DATABASE;
+    *out_book = book;
+    return BN_SUCCESS;
+}
+
+/* Columns: id, book_id, title, content, page_number, created_at, updated_at */
+static BnError note_from_row(sqlite3_stmt *stmt, Note **out_note) {
+    Note *note = calloc(1, sizeof(Note));
+    if (!note) {
+        return BN_ERROR_OUT_OF_MEMORY;
+    }
+    
+    note->id = sqlite3_column_int(stmt, 0);
+    note->book_id = sqlite3_column_int(stmt, 1);
+    note->title = column_strdup(stmt, 2);
+    note->content = column_strdup(stmt, 3);
+    note->page_number = sqlite3_column_int(stmt, 4);
+    note->created_at = (time_t)sqlite3_column_int64(stmt, 5);
+    note->updated_at = (time_t)sqlite3_column_int64(stmt, 6);
+    
+    if (!note->title || !note->content) {
+        note_free(note);
+        return BN_ERROR_OUT_OF_MEMORY;
+    }
+    
+    *out_note = note;
+    return BN_SUCCESS;
+}
+
+/* Borrowed variants: point into the statement's buffers, no allocation */
+static void book_borrow_row(sqlite3_stmt *stmt, Book *book) {
+    book->id = sqlite3_column_int(stmt, 0);
+    book->isbn = (char *)sqlite3_column_text(stmt, 1);
+    book->title = (char *)sqlite3_column_text(stmt, 2);
+    book->author = (char *)sqlite3_column_text(stmt, 3);
+    book->year = sqlite3_column_int(stmt, 4);
+    book->publisher = (char *)sqlite3_column_text(stmt, 5);
+    book->filepath = (char *)sqlite3_column_text(stmt, 6);
+    book->cover_path = (char *)sqlite3_column_text(stmt, 7);
+    book->added_at = (time_t)sqlite3_column_int64(stmt, 8);
+    book->updated_at = (time_t)sqlite3_column_int64(stmt, 9);
+}
+
+static void note_borrow_row(sqlite3_stmt *stmt, Note *note) {
+    note->id = sqlite3_column_int(stmt, 0);
+    note->book_id = sqlite3_column_int(stmt, 1);
+    note->title = (char *)sqlite3_column_text(stmt, 2);
+    note->content = (char *)sqlite3_column_text(stmt, 3);
+    note->page_number = sqlite3_column_int(stmt, 4);
+    note->created_at = (time_t)sqlite3_column_int64(stmt, 5);
+    note->updated_at = (time_t)sqlite3_column_int64(stmt, 6);
+}
+
+/*
+ * Step a bound statement to completion in a single pass, growing the
+ * output array geometrically. On failure nothing is returned to the caller.
+ */
+static BnError collect_books(sqlite3_stmt *stmt, Book ***out_books, int *out_count) {
+    Book **books = NULL;
+    int count = 0;
+    int capacity = 0;
+    BnError err = BN_SUCCESS;
+    
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        if (count == capacity) {
+            int new_capacity = capacity ? capacity * 2 : RESULT_INITIAL_CAPACITY;
+            Book **grown = realloc(books, new_capacity * sizeof(Book *));
+            if (!grown) {
+                err = BN_ERROR_OUT_OF_MEMORY;
+                break;
+            }
+            books = grown;
+            capacity = new_capacity;
+        }
+        
+        err = book_from_row(stmt, &books[count]);
+        if (err != BN_SUCCESS) {
+            break;
+        }
+        count++;
+    }
+    
+    if (err == BN_SUCCESS && rc != SQLITE_DONE) {
+        err = BN_ERROR_DATABASE;
+    }
+    
+    if (err != BN_SUCCESS) {
+        for (int i = 0; i < count; i++) {
+            book_free(books[i]);
+        }
+        free(books);
+        return err;
+    }
+    
+    *out_books = books;
+    *out_count = count;
+    return BN_SUCCESS;
+}
+
+static BnError collect_notes(sqlite3_stmt *stmt, Note ***out_notes, int *out_count) {
+    Note **notes = NULL;
+    int count = 0;
+    int capacity = 0;
+    BnError err = BN_SUCCESS;
+    
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        if (count == capacity) {
+            int new_capacity = capacity ? capacity * 2 : RESULT_INITIAL_CAPACITY;
+            Note **grown = realloc(notes, new_capacity * sizeof(Note *));
+            if (!grown) {
+                err = BN_ERROR_OUT_OF_MEMORY;
+                break;
+            }
+            notes = grown;
+            capacity = new_capacity;
+        }
+        
+        err = note_from_row(stmt, &notes[count]);
+        if (err != BN_SUCCESS) {
+            break;
+        }
+        count++;
+    }
+    
+    if (err == BN_SUCCESS && rc != SQLITE_DONE) {
+        err = BN_ERROR_DATABASE;
+    }
+    
+    if (err != BN_SUCCESS) {
+        for (int i = 0; i < count; i++) {
+            note_free(notes[i]);
+        }
+        free(notes);
+        return err;
     }
     
+    *out_notes = notes;
+    *out_count = count;
+    return BN_SUCCESS;
+}
+
+/* ============================================================================
+ * Book operations
+ * ========================================================================= */
+
+/* Map a failed write to an error code */
+static BnError write_error(Database *db) {
+    switch (sqlite3_extended_errcode(db->handle)) {
+        case SQLITE_CONSTRAINT_UNIQUE:
+        case SQLITE_CONSTRAINT_PRIMARYKEY:
+            return BN_ERROR_DUPLICATE;
+        case SQLITE_CONSTRAINT_FOREIGNKEY:
+            return BN_ERROR_NOT_FOUND;
+        case SQLITE_CONSTRAINT_NOTNULL:
+            return BN_ERROR_INVALID_ARG;
+        default:
+            return BN_ERROR_DATABASE;
+    }
+}
+
+/* Bind, execute and reset a prepared SQL_BOOK_INSERT for one book */
+static BnError step_book_insert(Database *db, sqlite3_stmt *stmt, Book *book) {
     // Bind parameters (1-indexed)
     sqlite3_bind_text(stmt, 1, book->isbn, -1, SQLITE_TRANSIENT);
     sqlite3_bind_text(stmt, 2, book->title, -1, SQLITE_TRANSIENT);
@@ -34,16 +331,100 @@ BnError db_book_insert(Database *db, Book *book) {
     sqlite3_bind_int64(stmt, 8, (sqlite3_int64)book->added_at);
     sqlite3_bind_int64(stmt, 9, (sqlite3_int64)book->updated_at);
     
-    rc = sqlite3_step(stmt);
-    if (rc != SQLITE_DONE) {
-        sqlite3_finalize(stmt);
-        return BN_ERROR_DATABASE;
+    int rc = sqlite3_step(stmt);
+    BnError err = BN_SUCCESS;
+    if (rc == SQLITE_DONE) {
+        // Get auto-generated ID
+        book->id = (int)sqlite3_last_insert_rowid(db->handle);
+    } else {
+        err = write_error(db);
+    }
+    
+    sqlite3_reset(stmt);
+    return err;
+}
+
+/* Bind, execute and reset a prepared SQL_NOTE_INSERT for one note */
+static BnError step_note_insert(Database *db, sqlite3_stmt *stmt, Note *note) {
+    sqlite3_bind_int(stmt, 1, note->book_id);
+    sqlite3_bind_text(stmt, 2, note->title, -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 3, note->content, -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int(stmt, 4, note->page_number);
+    sqlite3_bind_int64(stmt, 5, (sqlite3_int64)note->created_at);
+    sqlite3_bind_int64(stmt, 6, (sqlite3_int64)note->updated_at);
+    
+    int rc = sqlite3_step(stmt);
+    BnError err = BN_SUCCESS;
+    if (rc == SQLITE_DONE) {
+        note->id = (int)sqlite3_last_insert_rowid(db->handle);
+    } else {
+        err = write_error(db);
+    }
+    
+    sqlite3_reset(stmt);
+    return err;
+}
+
+BnError db_book_insert(Database *db, Book *book) {
+    if (!db || !db->handle || !book) {
+        return BN_ERROR_INVALID_ARG;
+    }
+    
+    sqlite3_stmt *stmt;
+    BnError err = db_stmt_acquire(db, SQL_BOOK_INSERT, &stmt);
+    if (err != BN_SUCCESS) {
+        return err;
+    }
+    
+    err = step_book_insert(db, stmt, book);
+    
+    db_stmt_release(db, stmt);
+    return err;
+}
+
+BnError db_book_insert_many(Database *db, Book **books, int count, BnError *row_errors, int *out_inserted) {
+    if (!db || !db->handle || (!books && count > 0) || count < 0) {
+        return BN_ERROR_INVALID_ARG;
+    }
+    
+    sqlite3_stmt *stmt;
+    BnError err = db_stmt_acquire(db, SQL_BOOK_INSERT, &stmt);
+    if (err != BN_SUCCESS) {
+        return err;
+    }
+    
+    err = db_begin_transaction(db);
+    if (err != BN_SUCCESS) {
+        db_stmt_release(db, stmt);
+        return err;
     }
     
-    // Get auto-generated ID
-    book->id = (int)sqlite3_last_insert_rowid(db->handle);
+    int inserted = 0;
+    for (int i = 0; i < count; i++) {
+        BnError row_err = books[i] ? step_book_insert(db, stmt, books[i]) : BN_ERROR_INVALID_ARG;
+        if (row_errors) {
+            row_errors[i] = row_err;
+        }
+        if (row_err == BN_SUCCESS) {
+            inserted++;
+        } else if (sqlite3_get_autocommit(db->handle)) {
+            // SQLite rolled back the whole transaction (I/O error, disk full, ...)
+            db_stmt_release(db, stmt);
+            return BN_ERROR_DATABASE;
+        }
+    }
+    
+    db_stmt_release(db, stmt);
     
-    sqlite3_finalize(stmt);
+    err = db_commit_transaction(db);
+    if (err != BN_SUCCESS) {
+        db_rollback_transaction(db);
+        return err;
+    }
+    
+    if (out_inserted) {
+        *out_inserted = inserted;
+    }
     return BN_SUCCESS;
 }
 
@@ -57,54 +438,23 @@ BnError db_book_get_by_id(Database *db, int id, Book **out_book) {
         "FROM books WHERE id = ?;";
     
     sqlite3_stmt *stmt;
-    int rc = sqlite3_prepare_v2(db->handle, sql, -1, &stmt, NULL);
-    if (rc != SQLITE_OK) {
-        return BN_ERROR_DATABASE;
+    BnError err = db_stmt_acquire(db, sql, &stmt);
+    if (err != BN_SUCCESS) {
+        return err;
     }
     
     sqlite3_bind_int(stmt, 1, id);
     
-    rc = sqlite3_step(stmt);
+    int rc = sqlite3_step(stmt);
     if (rc == SQLITE_ROW) {
-        Book *book = calloc(1, sizeof(Book));
-        if (!book) {
-            sqlite3_finalize(stmt);
-            return BN_ERROR_OUT_OF_MEMORY;
-        }
-        
-        book->id = sqlite3_column_int(stmt, 0);
-        
-        const char *isbn = (const char *)sqlite3_column_text(stmt, 1);
-        book->isbn = isbn ? strdup(isbn) : NULL;
-        
-        const char *title = (const char *)sqlite3_column_text(stmt, 2);
-        book->title = strdup(title);
-        
-        const char *author = (const char *)sqlite3_column_text(stmt, 3);
-        book->author = author ? strdup(author) : NULL;
-        
-        book->year = sqlite3_column_int(stmt, 4);
-        
-        const char *publisher = (const char *)sqlite3_column_text(stmt, 5);
-        book->publisher = publisher ? strdup(publisher) : NULL;
-        
-        const char *filepath = (const char *)sqlite3_column_text(stmt, 6);
-        book->filepath = strdup(filepath);
-
-        const char *cover_path = (const char *)sqlite3_column_text(stmt, 7);
-        book->cover_path = cover_path ? strdup(cover_path) : NULL;
-        
-        book->added_at = (time_t)sqlite3_column_int64(stmt, 8);
-        book->updated_at = (time_t)sqlite3_column_int64(stmt, 9);
-        
-        *out_book = book;
-        sqlite3_finalize(stmt);
-        return BN_SUCCESS;
+        err = book_from_row(stmt, out_book);
+        db_stmt_release(db, stmt);
+        return err;
     } else if (rc == SQLITE_DONE) {
-        sqlite3_finalize(stmt);
+        db_stmt_release(db, stmt);
         return BN_ERROR_NOT_FOUND;
     } else {
-        sqlite3_finalize(stmt);
+        db_stmt_release(db, stmt);
         return BN_ERROR_DATABASE;
     }
 }
@@ -114,84 +464,16 @@ BnError db_book_get_all(Database *db, Book ***out_books, int *out_count) {
         return BN_ERROR_INVALID_ARG;
     }
     
-    const char *sql = 
-        "SELECT id, isbn, title, author, year, publisher, filepath, cover_path, added_at, updated_at "
-        "FROM books ORDER BY title;";
-    
     sqlite3_stmt *stmt;
-    int rc = sqlite3_prepare_v2(db->handle, sql, -1, &stmt, NULL);
-    if (rc != SQLITE_OK) {
-        return BN_ERROR_DATABASE;
-    }
-    
-    // First, count rows
-    int count = 0;
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
-        count++;
-    }
-    sqlite3_reset(stmt);
-    
-    if (count == 0) {
-        *out_books = NULL;
-        *out_count = 0;
-        sqlite3_finalize(stmt);
-        return BN_SUCCESS;
-    }
-    
-    // Allocate array
-    Book **books = calloc(count, sizeof(Book *));
-    if (!books) {
-        sqlite3_finalize(stmt);
-        return BN_ERROR_OUT_OF_MEMORY;
-    }
-    
-    // Fetch rows
-    int i = 0;
-    while (sqlite3_step(stmt) == SQLITE_ROW && i < count) {
-        Book *book = calloc(1, sizeof(Book));
-        if (!book) {
-            // Cleanup on error
-            for (int j = 0; j < i; j++) {
-                book_free(books[j]);
-            }
-            free(books);
-            sqlite3_finalize(stmt);
-            return BN_ERROR_OUT_OF_MEMORY;
-        }
-        
-        book->id = sqlite3_column_int(stmt, 0);
-        
-        const char *isbn = (const char *)sqlite3_column_text(stmt, 1);
-        book->isbn = isbn ? strdup(isbn) : NULL;
-        
-        const char *title = (const char *)sqlite3_column_text(stmt, 2);
-        book->title = strdup(title);
-        
-        const char *author = (const char *)sqlite3_column_text(stmt, 3);
-        book->author = author ? strdup(author) : NULL;
-        
-        book->year = sqlite3_column_int(stmt, 4);
-        
-        const char *publisher = (const char *)sqlite3_column_text(stmt, 5);
-        book->publisher = publisher ? strdup(publisher) : NULL;
-        
-        const char *filepath = (const char *)sqlite3_column_text(stmt, 6);
-        book->filepath = strdup(filepath);
-
-        const char *cover_path = (const char *)sqlite3_column_text(stmt, 7);
-        book->cover_path = cover_path ? strdup(cover_path) : NULL;
-        
-        book->added_at = (time_t)sqlite3_column_int64(stmt, 8);
-        book->updated_at = (time_t)sqlite3_column_int64(stmt, 9);
-        
-        books[i++] = book;
+    BnError err = db_stmt_acquire(db, SQL_BOOK_SELECT_ALL, &stmt);
+    if (err != BN_SUCCESS) {
+        return err;
     }
     
-    *out_books = books;
-    *out_count = count;
+    err = collect_books(stmt, out_books, out_count);
     
-    sqlite3_finalize(stmt);
-    return BN_SUCCESS;
+    db_stmt_release(db, stmt);
+    return err;
 }
 
 BnError db_book_update(Database *db, const Book *book) {
@@ -204,9 +486,9 @@ BnError db_book_update(Database *db, const Book *book) {
         "publisher = ?, filepath = ?, cover_path = ?, updated_at = ? WHERE id = ?;";
     
     sqlite3_stmt *stmt;
-    int rc = sqlite3_prepare_v2(db->handle, sql, -1, &stmt, NULL);
-    if (rc != SQLITE_OK) {
-        return BN_ERROR_DATABASE;
+    BnError err = db_stmt_acquire(db, sql, &stmt);
+    if (err != BN_SUCCESS) {
+        return err;
     }
     
     sqlite3_bind_text(stmt, 1, book->isbn, -1, SQLITE_TRANSIENT);
@@ -219,8 +501,8 @@ BnError db_book_update(Database *db, const Book *book) {
     sqlite3_bind_int64(stmt, 8, (sqlite3_int64)book->updated_at);
     sqlite3_bind_int(stmt, 9, book->id);
     
-    rc = sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
+    int rc = sqlite3_step(stmt);
+    db_stmt_release(db, stmt);
     
     if (rc != SQLITE_DONE) {
         return BN_ERROR_DATABASE;
@@ -237,15 +519,15 @@ BnError db_book_delete(Database *db, int id) {
     const char *sql = "DELETE FROM books WHERE id = ?;";
     
     sqlite3_stmt *stmt;
-    int rc = sqlite3_prepare_v2(db->handle, sql, -1, &stmt, NULL);
-    if (rc != SQLITE_OK) {
-        return BN_ERROR_DATABASE;
+    BnError err = db_stmt_acquire(db, sql, &stmt);
+    if (err != BN_SUCCESS) {
+        return err;
     }
     
     sqlite3_bind_int(stmt, 1, id);
     
-    rc = sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
+    int rc = sqlite3_step(stmt);
+    db_stmt_release(db, stmt);
     
     if (rc != SQLITE_DONE) {
         return BN_ERROR_DATABASE;
@@ -263,248 +545,1617 @@ BnError db_note_insert(Database *db, Note *note) {
         return BN_ERROR_INVALID_ARG;
     }
     
-    const char *sql = 
-        "INSERT INTO notes (book_id, title, content, page_number, created_at, updated_at) "
-        "VALUES (?, ?, ?, ?, ?, ?);";
-    
     sqlite3_stmt *stmt;
-    int rc = sqlite3_prepare_v2(db->handle, sql, -1, &stmt, NULL);
-    if (rc != SQLITE_OK) {
-        return BN_ERROR_DATABASE;
-    }
-    
-    sqlite3_bind_int(stmt, 1, note->book_id);
-    sqlite3_bind_text(stmt, 2, note->title, -1, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 3, note->content, -1, SQLITE_TRANSIENT);
-    sqlite3_bind_int(stmt, 4, note->page_number);
-    sqlite3_bind_int64(stmt, 5, (sqlite3_int64)note->created_at);
-    sqlite3_bind_int64(stmt, 6, (sqlite3_int64)note->updated_at);
-    
-    rc = sqlite3_step(stmt);
-    if (rc != SQLITE_DONE) {
-        sqlite3_finalize(stmt);
-        return BN_ERROR_DATABASE;
+    BnError err = db_stmt_acquire(db, SQL_NOTE_INSERT, &stmt);
+    if (err != BN_SUCCESS) {
+        return err;
     }
     
-    note->id = (int)sqlite3_last_insert_rowid(db->handle);
+    err = step_note_insert(db, stmt, note);
     
-    sqlite3_finalize(stmt);
-    return BN_SUCCESS;
-}
-
-BnError db_note_get_by_id(Database *db, int id, Note **out_note) {
-    // TODO: Implement (similar to db_book_get_by_id)
-    (void)db;
-    (void)id;
-    (void)out_note;
-    return BN_ERROR_UNKNOWN;
+    db_stmt_release(db, stmt);
+    return err;
 }
 
-BnError db_note_get_by_book(Database *db, int book_id, Note ***out_notes, int *out_count) {
-    if (!db || !db->handle || !out_notes || !out_count || book_id <= 0) {
+BnError db_note_insert_many(Database *db, Note **notes, int count, BnError *row_errors, int *out_inserted) {
+    if (!db || !db->handle || (!notes && count > 0) || count < 0) {
         return BN_ERROR_INVALID_ARG;
     }
     
-    const char *sql = 
-        "SELECT id, book_id, title, content, page_number, created_at, updated_at "
-        "FROM notes WHERE book_id = ? ORDER BY created_at;";
-    
     sqlite3_stmt *stmt;
-    int rc = sqlite3_prepare_v2(db->handle, sql, -1, &stmt, NULL);
-    if (rc != SQLITE_OK) {
-        return BN_ERROR_DATABASE;
+    BnError err = db_stmt_acquire(db, SQL_NOTE_INSERT, &stmt);
+    if (err != BN_SUCCESS) {
+        return err;
     }
     
-    sqlite3_bind_int(stmt, 1, book_id);
-    
-    // Count rows
-    int count = 0;
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
-        count++;
+    err = db_begin_transaction(db);
+    if (err != BN_SUCCESS) {
+        db_stmt_release(db, stmt);
+        return err;
     }
-    sqlite3_reset(stmt);
-    sqlite3_bind_int(stmt, 1, book_id);
     
-    if (count == 0) {
-        *out_notes = NULL;
-        *out_count = 0;
-        sqlite3_finalize(stmt);
-        return BN_SUCCESS;
+    int inserted = 0;
+    for (int i = 0; i < count; i++) {
+        BnError row_err = notes[i] ? step_note_insert(db, stmt, notes[i]) : BN_ERROR_INVALID_ARG;
+        if (row_errors) {
+            row_errors[i] = row_err;
+        }
+        if (row_err == BN_SUCCESS) {
+            inserted++;
+        } else if (sqlite3_get_autocommit(db->handle)) {
+            // SQLite rolled back the whole transaction (I/O error, disk full, ...)
+            db_stmt_release(db, stmt);
+            return BN_ERROR_DATABASE;
+        }
     }
     
-    // Allocate array
-    Note **notes = calloc(count, sizeof(Note *));
-    if (!notes) {
-        sqlite3_finalize(stmt);
-        return BN_ERROR_OUT_OF_MEMORY;
-    }
+    db_stmt_release(db, stmt);
     
-    // Fetch rows
-    int i = 0;
-    while (sqlite3_step(stmt) == SQLITE_ROW && i < count) {
-        Note *note = calloc(1, sizeof(Note));
-        if (!note) {
-            for (int j = 0; j < i; j++) {
-                note_free(notes[j]);
-            }
-            free(notes);
-            sqlite3_finalize(stmt);
-            return BN_ERROR_OUT_OF_MEMORY;
-        }
-        
-        note->id = sqlite3_column_int(stmt, 0);
-        note->book_id = sqlite3_column_int(stmt, 1);
-        
-        const char *title = (const char *)sqlite3_column_text(stmt, 2);
-        note->title = strdup(title);
-        
-        const char *content = (const char *)sqlite3_column_text(stmt, 3);
-        note->content = strdup(content);
-        
-        note->page_number = sqlite3_column_int(stmt, 4);
-        note->created_at = (time_t)sqlite3_column_int64(stmt, 5);
-        note->updated_at = (time_t)sqlite3_column_int64(stmt, 6);
-        
-        notes[i++] = note;
+    err = db_commit_transaction(db);
+    if (err != BN_SUCCESS) {
+        db_rollback_transaction(db);
+        return err;
     }
     
-    *out_notes = notes;
-    *out_count = count;
-    
-    sqlite3_finalize(stmt);
+    if (out_inserted) {
+        *out_inserted = inserted;
+    }
     return BN_SUCCESS;
 }
 
-BnError db_note_update(Database *db, const Note *note) {
-    if (!db || !db->handle || !note || note->id <= 0) {
+BnError db_note_from_json(Database *db, const char *json, Note **out_note) {
+    if (!db || !db->handle || !json || !out_note) {
         return BN_ERROR_INVALID_ARG;
     }
     
-    const char *sql = 
-        "UPDATE notes SET title = ?, content = ?, page_number = ?, updated_at = ? "
-        "WHERE id = ?;";
+    // json_extract() raises on malformed input, so validate in a materialized
+    // CTE that yields no row for bad documents instead of letting it flatten
+    const char *sql =
+        "WITH doc(j) AS MATERIALIZED (SELECT ?1 WHERE json_valid(?1) AND json_type(?1) = 'object') "
+        "SELECT json_extract(j, '$.book_id'), json_extract(j, '$.title'), json_extract(j, '$.content'), "
+        "coalesce(json_extract(j, '$.page'), json_extract(j, '$.page_number'), 0) FROM doc;";
     
     sqlite3_stmt *stmt;
-    int rc = sqlite3_prepare_v2(db->handle, sql, -1, &stmt, NULL);
-    if (rc != SQLITE_OK) {
-        return BN_ERROR_DATABASE;
+    BnError err = db_stmt_acquire(db, sql, &stmt);
+    if (err != BN_SUCCESS) {
+        return err;
     }
     
-    sqlite3_bind_text(stmt, 1, note->title, -1, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 2, note->content, -1, SQLITE_TRANSIENT);
-    sqlite3_bind_int(stmt, 3, note->page_number);
-    sqlite3_bind_int64(stmt, 4, (sqlite3_int64)time(NULL));
-    sqlite3_bind_int(stmt, 5, note->id);
+    sqlite3_bind_text(stmt, 1, json, -1, SQLITE_STATIC);
     
-    rc = sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
+    int rc = sqlite3_step(stmt);
+    if (rc != SQLITE_ROW) {
+        db_stmt_release(db, stmt);
+        return rc == SQLITE_DONE ? BN_ERROR_INVALID_ARG : BN_ERROR_DATABASE;
+    }
     
-    if (rc != SQLITE_DONE) {
-        return BN_ERROR_DATABASE;
+    if (sqlite3_column_type(stmt, 0) != SQLITE_INTEGER || sqlite3_column_type(stmt, 2) != SQLITE_TEXT) {
+        db_stmt_release(db, stmt);
+        return BN_ERROR_INVALID_ARG;
     }
     
-    return BN_SUCCESS;
+    err = note_create(out_note,
+                      sqlite3_column_int(stmt, 0),
+                      (const char *)sqlite3_column_text(stmt, 1),
+                      (const char *)sqlite3_column_text(stmt, 2),
+                      sqlite3_column_int(stmt, 3));
+    
+    db_stmt_release(db, stmt);
+    return err;
 }
 
-BnError db_note_delete(Database *db, int id) {
-    if (!db || !db->handle || id <= 0) {
+BnError db_note_get_by_id(Database *db, int id, Note **out_note) {
+    if (!db || !db->handle || !out_note || id <= 0) {
         return BN_ERROR_INVALID_ARG;
     }
     
-    const char *sql = "DELETE FROM notes WHERE id = ?;";
-    
     sqlite3_stmt *stmt;
-    int rc = sqlite3_prepare_v2(db->handle, sql, -1, &stmt, NULL);
-    if (rc != SQLITE_OK) {
-        return BN_ERROR_DATABASE;
+    BnError err = db_stmt_acquire(db, SQL_NOTE_COLUMNS "WHERE id = ?;", &stmt);
+    if (err != BN_SUCCESS) {
+        return err;
     }
     
     sqlite3_bind_int(stmt, 1, id);
     
-    rc = sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
-    
-    if (rc != SQLITE_DONE) {
-        return BN_ERROR_DATABASE;
+    int rc = sqlite3_step(stmt);
+    if (rc == SQLITE_ROW) {
+        err = note_from_row(stmt, out_note);
+    } else if (rc == SQLITE_DONE) {
+        err = BN_ERROR_NOT_FOUND;
+    } else {
+        err = BN_ERROR_DATABASE;
     }
     
-    return BN_SUCCESS;
+    db_stmt_release(db, stmt);
+    return err;
 }
 
-BnError db_note_search(Database *db, const char *query, Note ***out_notes, int *out_count) {
-    if (!db || !db->handle || !query || !out_notes || !out_count) {
+BnError db_note_get_by_book(Database *db, int book_id, Note ***out_notes, int *out_count) {
+    if (!db || !db->handle || !out_notes || !out_count || book_id <= 0) {
+        return BN_ERROR_INVALID_ARG;
+    }
+    
+    sqlite3_stmt *stmt;
+    BnError err = db_stmt_acquire(db, SQL_NOTE_SELECT_BY_BOOK, &stmt);
+    if (err != BN_SUCCESS) {
+        return err;
+    }
+    
+    sqlite3_bind_int(stmt, 1, book_id);
+    
+    err = collect_notes(stmt, out_notes, out_count);
+    
+    db_stmt_release(db, stmt);
+    return err;
+}
+
+BnError db_note_update(Database *db, const Note *note) {
+    if (!db || !db->handle || !note || note->id <= 0) {
         return BN_ERROR_INVALID_ARG;
     }
     
     const char *sql = 
-        "SELECT n.id, n.book_id, n.title, n.content, n.page_number, n.created_at, n.updated_at "
-        "FROM notes n "
-        "JOIN notes_fts fts ON n.id = fts.rowid "
-        "WHERE fts.content MATCH ? "
-        "ORDER BY n.created_at DESC;";
+        "UPDATE notes SET title = ?, content = ?, page_number = ?, updated_at = ? "
+        "WHERE id = ?;";
     
     sqlite3_stmt *stmt;
-    int rc = sqlite3_prepare_v2(db->handle, sql, -1, &stmt, NULL);
-    if (rc != SQLITE_OK) {
+    BnError err = db_stmt_acquire(db, sql, &stmt);
+    if (err != BN_SUCCESS) {
+        return err;
+    }
+    
+    sqlite3_bind_text(stmt, 1, note->title, -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 2, note->content, -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int(stmt, 3, note->page_number);
+    sqlite3_bind_int64(stmt, 4, (sqlite3_int64)time(NULL));
+    sqlite3_bind_int(stmt, 5, note->id);
+    
+    int rc = sqlite3_step(stmt);
+    db_stmt_release(db, stmt);
+    
+    if (rc != SQLITE_DONE) {
         return BN_ERROR_DATABASE;
     }
     
-    sqlite3_bind_text(stmt, 1, query, -1, SQLITE_TRANSIENT);
+    return BN_SUCCESS;
+}
+
+BnError db_note_delete(Database *db, int id) {
+    if (!db || !db->handle || id <= 0) {
+        return BN_ERROR_INVALID_ARG;
+    }
     
-    // Count rows
-    int count = 0;
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
-        count++;
+    const char *sql = "DELETE FROM notes WHERE id = ?;";
+    
+    sqlite3_stmt *stmt;
+    BnError err = db_stmt_acquire(db, sql, &stmt);
+    if (err != BN_SUCCESS) {
+        return err;
     }
-    sqlite3_reset(stmt);
+    
+    sqlite3_bind_int(stmt, 1, id);
+    
+    int rc = sqlite3_step(stmt);
+    db_stmt_release(db, stmt);
+    
+    if (rc != SQLITE_DONE) {
+        return BN_ERROR_DATABASE;
+    }
+    
+    return BN_SUCCESS;
+}
+
+BnError db_note_search(Database *db, const char *query, Note ***out_notes, int *out_count) {
+    if (!db || !db->handle || !query || !out_notes || !out_count) {
+        return BN_ERROR_INVALID_ARG;
+    }
+    
+    sqlite3_stmt *stmt;
+    BnError err = db_stmt_acquire(db, SQL_NOTE_SEARCH, &stmt);
+    if (err != BN_SUCCESS) {
+        return err;
+    }
+    
     sqlite3_bind_text(stmt, 1, query, -1, SQLITE_TRANSIENT);
     
-    if (count == 0) {
-        *out_notes = NULL;
-        *out_count = 0;
-        sqlite3_finalize(stmt);
-        return BN_SUCCESS;
+    err = collect_notes(stmt, out_notes, out_count);
+    
+    db_stmt_release(db, stmt);
+    return err;
+}
+
+/* ============================================================================
+ * Arena-backed result sets
+ * ========================================================================= */
+
+static BnError book_result_append(BookResultSet *set, sqlite3_stmt *stmt) {
+    if (set->count == set->capacity) {
+        int capacity = set->capacity ? set->capacity * 2 : RESULT_INITIAL_CAPACITY;
+        Book *grown = realloc(set->books, capacity * sizeof(Book));
+        if (!grown) {
+            return BN_ERROR_OUT_OF_MEMORY;
+        }
+        set->books = grown;
+        set->capacity = capacity;
     }
     
-    // Allocate array
-    Note **notes = calloc(count, sizeof(Note *));
-    if (!notes) {
-        sqlite3_finalize(stmt);
+    Book row;
+    book_borrow_row(stmt, &row);
+    
+    Book *book = &set->books[set->count];
+    *book = row;
+    book->isbn = arena_strdup(&set->arena, row.isbn);
+    book->title = arena_strdup(&set->arena, row.title);
+    book->author = arena_strdup(&set->arena, row.author);
+    book->publisher = arena_strdup(&set->arena, row.publisher);
+    book->filepath = arena_strdup(&set->arena, row.filepath);
+    book->cover_path = arena_strdup(&set->arena, row.cover_path);
+    
+    if ((row.isbn && !book->isbn) || !book->title || (row.author && !book->author) ||
+        (row.publisher && !book->publisher) || !book->filepath ||
+        (row.cover_path && !book->cover_path)) {
         return BN_ERROR_OUT_OF_MEMORY;
     }
     
-    // Fetch rows
-    int i = 0;
-    while (sqlite3_step(stmt) == SQLITE_ROW && i < count) {
-        Note *note = calloc(1, sizeof(Note));
-        if (!note) {
-            for (int j = 0; j < i; j++) {
-                note_free(notes[j]);
-            }
-            free(notes);
-            sqlite3_finalize(stmt);
+    set->count++;
+    return BN_SUCCESS;
+}
+
+static BnError note_result_append(NoteResultSet *set, sqlite3_stmt *stmt) {
+    if (set->count == set->capacity) {
+        int capacity = set->capacity ? set->capacity * 2 : RESULT_INITIAL_CAPACITY;
+        Note *grown = realloc(set->notes, capacity * sizeof(Note));
+        if (!grown) {
             return BN_ERROR_OUT_OF_MEMORY;
         }
+        set->notes = grown;
+        set->capacity = capacity;
+    }
+    
+    Note row;
+    note_borrow_row(stmt, &row);
+    
+    Note *note = &set->notes[set->count];
+    *note = row;
+    note->title = arena_strdup(&set->arena, row.title);
+    note->content = arena_strdup(&set->arena, row.content);
+    
+    if (!note->title || !note->content) {
+        return BN_ERROR_OUT_OF_MEMORY;
+    }
+    
+    set->count++;
+    return BN_SUCCESS;
+}
+
+static BnError collect_book_set(Database *db, sqlite3_stmt *stmt, BookResultSet **out_set) {
+    BookResultSet *set = calloc(1, sizeof(BookResultSet));
+    if (!set) {
+        db_stmt_release(db, stmt);
+        return BN_ERROR_OUT_OF_MEMORY;
+    }
+    arena_init(&set->arena, 0);
+    
+    BnError err = BN_SUCCESS;
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        err = book_result_append(set, stmt);
+        if (err != BN_SUCCESS) {
+            break;
+        }
+    }
+    if (err == BN_SUCCESS && rc != SQLITE_DONE) {
+        err = BN_ERROR_DATABASE;
+    }
+    
+    db_stmt_release(db, stmt);
+    
+    if (err != BN_SUCCESS) {
+        db_book_result_free(set);
+        return err;
+    }
+    
+    *out_set = set;
+    return BN_SUCCESS;
+}
+
+static BnError collect_note_set(Database *db, sqlite3_stmt *stmt, NoteResultSet **out_set) {
+    NoteResultSet *set = calloc(1, sizeof(NoteResultSet));
+    if (!set) {
+        db_stmt_release(db, stmt);
+        return BN_ERROR_OUT_OF_MEMORY;
+    }
+    arena_init(&set->arena, 0);
+    
+    BnError err = BN_SUCCESS;
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        err = note_result_append(set, stmt);
+        if (err != BN_SUCCESS) {
+            break;
+        }
+    }
+    if (err == BN_SUCCESS && rc != SQLITE_DONE) {
+        err = BN_ERROR_DATABASE;
+    }
+    
+    db_stmt_release(db, stmt);
+    
+    if (err != BN_SUCCESS) {
+        db_note_result_free(set);
+        return err;
+    }
+    
+    *out_set = set;
+    return BN_SUCCESS;
+}
+
+BnError db_book_get_all_arena(Database *db, BookResultSet **out_set) {
+    if (!db || !db->handle || !out_set) {
+        return BN_ERROR_INVALID_ARG;
+    }
+    
+    sqlite3_stmt *stmt;
+    BnError err = db_stmt_acquire(db, SQL_BOOK_SELECT_ALL, &stmt);
+    if (err != BN_SUCCESS) {
+        return err;
+    }
+    
+    return collect_book_set(db, stmt, out_set);
+}
+
+BnError db_note_get_by_book_arena(Database *db, int book_id, NoteResultSet **out_set) {
+    if (!db || !db->handle || !out_set || book_id <= 0) {
+        return BN_ERROR_INVALID_ARG;
+    }
+    
+    sqlite3_stmt *stmt;
+    BnError err = db_stmt_acquire(db, SQL_NOTE_SELECT_BY_BOOK, &stmt);
+    if (err != BN_SUCCESS) {
+        return err;
+    }
+    
+    sqlite3_bind_int(stmt, 1, book_id);
+    return collect_note_set(db, stmt, out_set);
+}
+
+BnError db_note_search_arena(Database *db, const char *query, NoteResultSet **out_set) {
+    if (!db || !db->handle || !query || !out_set) {
+        return BN_ERROR_INVALID_ARG;
+    }
+    
+    sqlite3_stmt *stmt;
+    BnError err = db_stmt_acquire(db, SQL_NOTE_SEARCH, &stmt);
+    if (err != BN_SUCCESS) {
+        return err;
+    }
+    
+    sqlite3_bind_text(stmt, 1, query, -1, SQLITE_TRANSIENT);
+    return collect_note_set(db, stmt, out_set);
+}
+
+BnError db_book_get_page(Database *db, BookSort sort, int after_id, int limit, BookResultSet **out_set) {
+    if (!db || !db->handle || !out_set || limit <= 0 || after_id < 0 ||
+        sort < BOOK_SORT_TITLE || sort > BOOK_SORT_ADDED) {
+        return BN_ERROR_INVALID_ARG;
+    }
+    
+    sqlite3_stmt *stmt;
+    BnError err = db_stmt_acquire(db, SQL_BOOK_PAGE[sort][after_id > 0], &stmt);
+    if (err != BN_SUCCESS) {
+        return err;
+    }
+    
+    sqlite3_bind_int(stmt, 1, after_id);
+    sqlite3_bind_int(stmt, 2, limit);
+    return collect_book_set(db, stmt, out_set);
+}
+
+BnError db_note_get_page_by_book(Database *db, int book_id, NoteSort sort, int after_id, int limit,
+                                 NoteResultSet **out_set) {
+    if (!db || !db->handle || !out_set || book_id <= 0 || limit <= 0 || after_id < 0 ||
+        sort < NOTE_SORT_CREATED || sort > NOTE_SORT_PAGE) {
+        return BN_ERROR_INVALID_ARG;
+    }
+    
+    sqlite3_stmt *stmt;
+    BnError err = db_stmt_acquire(db, SQL_NOTE_PAGE[sort][after_id > 0], &stmt);
+    if (err != BN_SUCCESS) {
+        return err;
+    }
+    
+    sqlite3_bind_int(stmt, 1, after_id);
+    sqlite3_bind_int(stmt, 2, limit);
+    sqlite3_bind_int(stmt, 3, book_id);
+    return collect_note_set(db, stmt, out_set);
+}
+
+/* Append text to out as an FTS5 string, doubling embedded quotes */
+static char *fts_append_quoted(char *out, const char *text, size_t len) {
+    *out++ = '"';
+    for (size_t i = 0; i < len; i++) {
+        if (text[i] == '"') {
+            *out++ = '"';
+        }
+        *out++ = text[i];
+    }
+    *out++ = '"';
+    return out;
+}
+
+/* FTS5 operator spelled by word (uppercase only, as FTS5 has it), or NULL */
+static const char *fts_operator(const char *word, size_t len) {
+    static const char *const operators[] = { "AND", "OR", "NOT", "NEAR" };
+    for (size_t i = 0; i < sizeof(operators) / sizeof(operators[0]); i++) {
+        if (strlen(operators[i]) == len && strncmp(word, operators[i], len) == 0) {
+            return operators[i];
+        }
+    }
+    return NULL;
+}
+
+BnError db_fts_word_query(const char *text, int flags, char **out_query) {
+    if (!text || !out_query) {
+        return BN_ERROR_INVALID_ARG;
+    }
+    
+    size_t len = strlen(text);
+    // Each input byte yields at most 6: a one-byte word becomes " OR "x"*"
+    // at worst, and NEAR( ) fits in the five bytes of " NEAR"
+    char *query = malloc(len * 6 + 1);
+    if (!query) {
+        return BN_ERROR_OUT_OF_MEMORY;
+    }
+    
+    char *out = query;
+    char *group = NULL;             // Start of the last term, or of its NEAR group
+    char *last_end = NULL;          // Just past the last quoted term
+    int last_prefix = 0;
+    int in_near = 0;                // The last term closed a NEAR group
+    const char *op = NULL;          // Operator waiting for its right-hand term
+    const char *p = text;
+    while (*p) {
+        while (*p && isspace((unsigned char)*p)) {
+            p++;
+        }
+        if (!*p) {
+            break;
+        }
         
-        note->id = sqlite3_column_int(stmt, 0);
-        note->book_id = sqlite3_column_int(stmt, 1);
-        
-        const char *title = (const char *)sqlite3_column_text(stmt, 2);
-        note->title = strdup(title);
-        
-        const char *content = (const char *)sqlite3_column_text(stmt, 3);
-        note->content = strdup(content);
-        
-        note->page_number = sqlite3_column_int(stmt, 4);
-        note->created_at = (time_t)sqlite3_column_int64(stmt, 5);
-        note->updated_at = (time_t)sqlite3_column_int64(stmt, 6);
+        const char *term;
+        size_t term_len;
+        int prefix;
+        const char *close = *p == '"' ? strchr(p + 1, '"') : NULL;
+        if (close) {
+            // A quoted phrase, optionally followed by * for a prefix
+            term = p + 1;
+            term_len = (size_t)(close - term);
+            p = close + 1;
+            prefix = *p == '*';
+            p += prefix;
+        } else {
+            // A word runs to the next space; an unbalanced quote is literal
+            size_t word = 0;
+            while (p[word] && !isspace((unsigned char)p[word])) {
+                word++;
+            }
+            
+            // Operators only count between two terms, otherwise they are words
+            const char *keyword = (flags & DB_FTS_OPERATORS) && group && !op
+                ? fts_operator(p, word) : NULL;
+            if (keyword) {
+                op = keyword;
+                p += word;
+                continue;
+            }
+            
+            // A trailing * (on more than a lone *) asks for a prefix match
+            prefix = word > 1 && p[word - 1] == '*';
+            term = p;
+            term_len = word - prefix;
+            p += word;
+        }
+        if (term_len == 0) {
+            continue;
+        }
+        prefix |= (flags & DB_FTS_PREFIX_ALL) != 0;
         
-        notes[i++] = note;
+        if (op && strcmp(op, "NEAR") == 0) {
+            // FTS5 only has NEAR(a b ...): wrap the previous term, or extend its group
+            if (in_near) {
+                out--;
+            } else {
+                memmove(group + 5, group, (size_t)(out - group));
+                memcpy(group, "NEAR(", 5);
+                out += 5;
+            }
+            *out++ = ' ';
+        } else {
+            if (op) {
+                out += sprintf(out, " %s ", op);
+            } else if (out != query) {
+                *out++ = ' ';
+            }
+            group = out;
+        }
+        out = fts_append_quoted(out, term, term_len);
+        if (prefix) {
+            *out++ = '*';
+        }
+        last_end = out;
+        last_prefix = prefix;
+        in_near = op && strcmp(op, "NEAR") == 0;
+        if (in_near) {
+            *out++ = ')';
+        }
+        op = NULL;
     }
     
-    *out_notes = notes;
-    *out_count = count;
+    if (out == query) {
+        // Nothing but whitespace, empty phrases or operators
+        free(query);
+        return BN_ERROR_INVALID_ARG;
+    }
+    if ((flags & DB_FTS_PREFIX_LAST) && !last_prefix) {
+        memmove(last_end + 1, last_end, (size_t)(out - last_end));
+        *last_end = '*';
+        out++;
+    }
+    // An operator left waiting at the end (still being typed) is dropped
+    *out = '\0';
     
-    sqlite3_finalize(stmt);
+    *out_query = query;
     return BN_SUCCESS;
 }
+
+BnError db_book_search(Database *db, const char *text, int limit, BookResultSet **out_set) {
+    if (!db || !db->handle || !text || !out_set || limit < 0) {
+        return BN_ERROR_INVALID_ARG;
+    }
+    
+    char *query = NULL;
+    BnError err = db_fts_word_query(text, DB_FTS_PREFIX_ALL, &query);
+    if (err != BN_SUCCESS) {
+        return err;
+    }
+    
+    sqlite3_stmt *stmt;
+    err = db_stmt_acquire(db, SQL_BOOK_SEARCH, &stmt);
+    if (err != BN_SUCCESS) {
+        free(query);
+        return err;
+    }
+    
+    sqlite3_bind_text(stmt, 1, query, -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int(stmt, 2, limit > 0 ? limit : -1);
+    free(query);
+    
+    return collect_book_set(db, stmt, out_set);
+}
+
+void db_book_result_free(BookResultSet *set) {
+    if (!set) {
+        return;
+    }
+    
+    arena_free(&set->arena);
+    free(set->books);
+    free(set);
+}
+
+void db_note_result_free(NoteResultSet *set) {
+    if (!set) {
+        return;
+    }
+    
+    arena_free(&set->arena);
+    free(set->notes);
+    free(set);
+}
+
+/* ============================================================================
+ * Counts
+ * ========================================================================= */
+
+static BnError count_query(Database *db, const char *sql, int bind_id, int *out_count) {
+    sqlite3_stmt *stmt;
+    BnError err = db_stmt_acquire(db, sql, &stmt);
+    if (err != BN_SUCCESS) {
+        return err;
+    }
+    
+    if (bind_id > 0) {
+        sqlite3_bind_int(stmt, 1, bind_id);
+    }
+    
+    int rc = sqlite3_step(stmt);
+    if (rc == SQLITE_ROW) {
+        *out_count = sqlite3_column_int(stmt, 0);
+        err = BN_SUCCESS;
+    } else {
+        err = BN_ERROR_DATABASE;
+    }
+    
+    db_stmt_release(db, stmt);
+    return err;
+}
+
+BnError db_book_count(Database *db, int *out_count) {
+    if (!db || !db->handle || !out_count) {
+        return BN_ERROR_INVALID_ARG;
+    }
+    
+    return count_query(db, "SELECT COUNT(*) FROM books;", 0, out_count);
+}
+
+BnError db_note_count_by_book(Database *db, int book_id, int *out_count) {
+    if (!db || !db->handle || !out_count || book_id <= 0) {
+        return BN_ERROR_INVALID_ARG;
+    }
+    
+    return count_query(db, "SELECT COUNT(*) FROM notes WHERE book_id = ?;", book_id, out_count);
+}
+
+/* ============================================================================
+ * Statistics
+ * ========================================================================= */
+
+#define SQL_BOOK_STATS_SELECT \
+    "SELECT b.id, b.title, count(n.id), coalesce(sum(word_count(n.content)), 0), " \
+    "max(b.updated_at, coalesce(max(n.updated_at), 0)) AS last_updated " \
+    "FROM books b LEFT JOIN notes n ON n.book_id = b.id GROUP BY b.id "
+
+static const char *SQL_BOOK_STATS_BY_NOTES =
+    SQL_BOOK_STATS_SELECT "ORDER BY count(n.id) DESC, b.id LIMIT ?;";
+
+static const char *SQL_BOOK_STATS_BY_WORDS =
+    SQL_BOOK_STATS_SELECT "ORDER BY 4 DESC, b.id LIMIT ?;";
+
+static const char *SQL_BOOK_STATS_BY_UPDATED =
+    SQL_BOOK_STATS_SELECT "ORDER BY last_updated DESC, b.id LIMIT ?;";
+
+BnError db_library_totals(Database *db, LibraryTotals *out_totals) {
+    if (!db || !db->handle || !out_totals) {
+        return BN_ERROR_INVALID_ARG;
+    }
+    
+    const char *sql =
+        "SELECT (SELECT count(*) FROM books), count(*), count(page_number > 0 OR NULL), "
+        "coalesce(sum(word_count(content)), 0), "
+        "max(coalesce(max(updated_at), 0), (SELECT coalesce(max(updated_at), 0) FROM books)) "
+        "FROM notes;";
+    
+    sqlite3_stmt *stmt;
+    BnError err = db_stmt_acquire(db, sql, &stmt);
+    if (err != BN_SUCCESS) {
+        return err;
+    }
+    
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        out_totals->books = sqlite3_column_int(stmt, 0);
+        out_totals->notes = sqlite3_column_int(stmt, 1);
+        out_totals->paged_notes = sqlite3_column_int(stmt, 2);
+        out_totals->words = sqlite3_column_int64(stmt, 3);
+        out_totals->last_updated = sqlite3_column_int64(stmt, 4);
+    } else {
+        err = BN_ERROR_DATABASE;
+    }
+    
+    db_stmt_release(db, stmt);
+    return err;
+}
+
+BnError db_note_counts_by_book(Database *db, BookNoteCount **out_counts, int *out_count) {
+    if (!db || !db->handle || !out_counts || !out_count) {
+        return BN_ERROR_INVALID_ARG;
+    }
+    
+    sqlite3_stmt *stmt;
+    BnError err = db_stmt_acquire(db, "SELECT book_id, count(*) FROM notes GROUP BY book_id;", &stmt);
+    if (err != BN_SUCCESS) {
+        return err;
+    }
+    
+    BookNoteCount *counts = NULL;
+    int count = 0;
+    int capacity = 0;
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        if (count == capacity) {
+            int new_capacity = capacity ? capacity * 2 : RESULT_INITIAL_CAPACITY;
+            BookNoteCount *grown = realloc(counts, new_capacity * sizeof(BookNoteCount));
+            if (!grown) {
+                err = BN_ERROR_OUT_OF_MEMORY;
+                break;
+            }
+            counts = grown;
+            capacity = new_capacity;
+        }
+        counts[count].book_id = sqlite3_column_int(stmt, 0);
+        counts[count].note_count = sqlite3_column_int(stmt, 1);
+        count++;
+    }
+    if (err == BN_SUCCESS && rc != SQLITE_DONE) {
+        err = BN_ERROR_DATABASE;
+    }
+    
+    db_stmt_release(db, stmt);
+    
+    if (err != BN_SUCCESS) {
+        free(counts);
+        return err;
+    }
+    
+    *out_counts = counts;
+    *out_count = count;
+    return BN_SUCCESS;
+}
+
+BnError db_book_stats(Database *db, BookStatsSort sort, int limit, BookStatsSet **out_set) {
+    if (!db || !db->handle || !out_set || limit < 0) {
+        return BN_ERROR_INVALID_ARG;
+    }
+    
+    const char *sql = sort == BOOK_STATS_BY_WORDS ? SQL_BOOK_STATS_BY_WORDS :
+                      sort == BOOK_STATS_BY_UPDATED ? SQL_BOOK_STATS_BY_UPDATED :
+                      SQL_BOOK_STATS_BY_NOTES;
+    
+    sqlite3_stmt *stmt;
+    BnError err = db_stmt_acquire(db, sql, &stmt);
+    if (err != BN_SUCCESS) {
+        return err;
+    }
+    sqlite3_bind_int(stmt, 1, limit > 0 ? limit : -1);
+    
+    BookStatsSet *set = calloc(1, sizeof(BookStatsSet));
+    if (!set) {
+        db_stmt_release(db, stmt);
+        return BN_ERROR_OUT_OF_MEMORY;
+    }
+    arena_init(&set->arena, 0);
+    
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        if (set->count == set->capacity) {
+            int capacity = set->capacity ? set->capacity * 2 : RESULT_INITIAL_CAPACITY;
+            BookStats *grown = realloc(set->rows, capacity * sizeof(BookStats));
+            if (!grown) {
+                err = BN_ERROR_OUT_OF_MEMORY;
+                break;
+            }
+            set->rows = grown;
+            set->capacity = capacity;
+        }
+        
+        BookStats *row = &set->rows[set->count];
+        row->book_id = sqlite3_column_int(stmt, 0);
+        row->title = arena_strdup(&set->arena, (const char *)sqlite3_column_text(stmt, 1));
+        row->note_count = sqlite3_column_int(stmt, 2);
+        row->word_count = sqlite3_column_int64(stmt, 3);
+        row->last_updated = sqlite3_column_int64(stmt, 4);
+        if (!row->title) {
+            err = BN_ERROR_OUT_OF_MEMORY;
+            break;
+        }
+        set->count++;
+    }
+    if (err == BN_SUCCESS && rc != SQLITE_DONE) {
+        err = BN_ERROR_DATABASE;
+    }
+    
+    db_stmt_release(db, stmt);
+    
+    if (err != BN_SUCCESS) {
+        db_book_stats_free(set);
+        return err;
+    }
+    
+    *out_set = set;
+    return BN_SUCCESS;
+}
+
+void db_book_stats_free(BookStatsSet *set) {
+    if (!set) {
+        return;
+    }
+    
+    arena_free(&set->arena);
+    free(set->rows);
+    free(set);
+}
+
+BnError db_note_page_ranges(Database *db, int book_id, int bucket_size,
+                            PageRangeCount **out_ranges, int *out_count) {
+    if (!db || !db->handle || !out_ranges || !out_count || book_id <= 0 || bucket_size <= 0) {
+        return BN_ERROR_INVALID_ARG;
+    }
+    
+    const char *sql =
+        "SELECT (page_number - 1) / ?2 AS bucket, count(*) FROM notes "
+        "WHERE book_id = ?1 AND page_number > 0 GROUP BY bucket ORDER BY bucket;";
+    
+    sqlite3_stmt *stmt;
+    BnError err = db_stmt_acquire(db, sql, &stmt);
+    if (err != BN_SUCCESS) {
+        return err;
+    }
+    sqlite3_bind_int(stmt, 1, book_id);
+    sqlite3_bind_int(stmt, 2, bucket_size);
+    
+    PageRangeCount *ranges = NULL;
+    int count = 0;
+    int capacity = 0;
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        if (count == capacity) {
+            int new_capacity = capacity ? capacity * 2 : RESULT_INITIAL_CAPACITY;
+            PageRangeCount *grown = realloc(ranges, new_capacity * sizeof(PageRangeCount));
+            if (!grown) {
+                err = BN_ERROR_OUT_OF_MEMORY;
+                break;
+            }
+            ranges = grown;
+            capacity = new_capacity;
+        }
+        int bucket = sqlite3_column_int(stmt, 0);
+        ranges[count].first_page = bucket * bucket_size + 1;
+        ranges[count].last_page = (bucket + 1) * bucket_size;
+        ranges[count].note_count = sqlite3_column_int(stmt, 1);
+        count++;
+    }
+    if (err == BN_SUCCESS && rc != SQLITE_DONE) {
+        err = BN_ERROR_DATABASE;
+    }
+    
+    db_stmt_release(db, stmt);
+    
+    if (err != BN_SUCCESS) {
+        free(ranges);
+        return err;
+    }
+    
+    *out_ranges = ranges;
+    *out_count = count;
+    return BN_SUCCESS;
+}
+
+/* ============================================================================
+ * Cursors
+ * ========================================================================= */
+
+BnError db_book_cursor_open(Database *db, BookSort sort, BookCursor **out_cursor) {
+    if (!db || !db->handle || !out_cursor || sort < BOOK_SORT_TITLE || sort > BOOK_SORT_ADDED) {
+        return BN_ERROR_INVALID_ARG;
+    }
+    
+    BookCursor *cursor = calloc(1, sizeof(BookCursor));
+    if (!cursor) {
+        return BN_ERROR_OUT_OF_MEMORY;
+    }
+    
+    // The first-page statement of the sort key, without a limit
+    BnError err = db_stmt_acquire(db, SQL_BOOK_PAGE[sort][0], &cursor->stmt);
+    if (err != BN_SUCCESS) {
+        free(cursor);
+        return err;
+    }
+    sqlite3_bind_int(cursor->stmt, 2, -1);
+    
+    cursor->db = db;
+    *out_cursor = cursor;
+    return BN_SUCCESS;
+}
+
+BnError db_book_cursor_next(BookCursor *cursor, const Book **out_book) {
+    if (!cursor || !cursor->stmt || !out_book) {
+        return BN_ERROR_INVALID_ARG;
+    }
+    
+    int rc = sqlite3_step(cursor->stmt);
+    if (rc == SQLITE_ROW) {
+        book_borrow_row(cursor->stmt, &cursor->row);
+        *out_book = &cursor->row;
+        return BN_SUCCESS;
+    }
+    
+    *out_book = NULL;
+    return rc == SQLITE_DONE ? BN_SUCCESS : BN_ERROR_DATABASE;
+}
+
+void db_book_cursor_close(BookCursor *cursor) {
+    if (!cursor) {
+        return;
+    }
+    
+    db_stmt_release(cursor->db, cursor->stmt);
+    free(cursor);
+}
+
+static BnError note_cursor_open(Database *db, const char *sql, NoteCursor **out_cursor) {
+    NoteCursor *cursor = calloc(1, sizeof(NoteCursor));
+    if (!cursor) {
+        return BN_ERROR_OUT_OF_MEMORY;
+    }
+    
+    BnError err = db_stmt_acquire(db, sql, &cursor->stmt);
+    if (err != BN_SUCCESS) {
+        free(cursor);
+        return err;
+    }
+    
+    cursor->db = db;
+    *out_cursor = cursor;
+    return BN_SUCCESS;
+}
+
+BnError db_note_cursor_open_by_book(Database *db, int book_id, NoteSort sort, NoteCursor **out_cursor) {
+    if (!db || !db->handle || !out_cursor || book_id <= 0 ||
+        sort < NOTE_SORT_CREATED || sort > NOTE_SORT_PAGE) {
+        return BN_ERROR_INVALID_ARG;
+    }
+    
+    // The first-page statement of the sort key, without a limit
+    BnError err = note_cursor_open(db, SQL_NOTE_PAGE[sort][0], out_cursor);
+    if (err != BN_SUCCESS) {
+        return err;
+    }
+    
+    sqlite3_bind_int((*out_cursor)->stmt, 2, -1);
+    sqlite3_bind_int((*out_cursor)->stmt, 3, book_id);
+    return BN_SUCCESS;
+}
+
+BnError db_note_cursor_open_search(Database *db, const char *query, NoteCursor **out_cursor) {
+    if (!db || !db->handle || !query || !out_cursor) {
+        return BN_ERROR_INVALID_ARG;
+    }
+    
+    BnError err = note_cursor_open(db, SQL_NOTE_SEARCH, out_cursor);
+    if (err != BN_SUCCESS) {
+        return err;
+    }
+    
+    sqlite3_bind_text((*out_cursor)->stmt, 1, query, -1, SQLITE_TRANSIENT);
+    return BN_SUCCESS;
+}
+
+BnError db_note_cursor_next(NoteCursor *cursor, const Note **out_note) {
+    if (!cursor || !cursor->stmt || !out_note) {
+        return BN_ERROR_INVALID_ARG;
+    }
+    
+    int rc = sqlite3_step(cursor->stmt);
+    if (rc == SQLITE_ROW) {
+        note_borrow_row(cursor->stmt, &cursor->row);
+        *out_note = &cursor->row;
+        return BN_SUCCESS;
+    }
+    
+    *out_note = NULL;
+    return rc == SQLITE_DONE ? BN_SUCCESS : BN_ERROR_DATABASE;
+}
+
+void db_note_cursor_close(NoteCursor *cursor) {
+    if (!cursor) {
+        return;
+    }
+    
+    db_stmt_release(cursor->db, cursor->stmt);
+    free(cursor);
+}
+
+/* ============================================================================
+ * Ranked search
+ * ========================================================================= */
+
+void db_search_options_init(SearchOptions *opts) {
+    if (!opts) {
+        return;
+    }
+    
+    opts->mode = SEARCH_MODE_WORDS;
+    opts->limit = 50;
+    opts->title_weight = 2.0;
+    opts->content_weight = 1.0;
+    opts->mark_open = "[";
+    opts->mark_close = "]";
+    opts->snippet_tokens = 16;
+}
+
+/* Length of a UTF-8 sequence from its lead byte */
+static int utf8_char_len(unsigned char c) {
+    if (c >= 0xF0) return 4;
+    if (c >= 0xE0) return 3;
+    if (c >= 0xC0) return 2;
+    return 1;
+}
+
+/* Build the notes_trigram query for a substring or fuzzy search. The
+ * trigram tokenizer cannot match fewer than three characters. */
+static BnError fts_trigram_query(const char *text, SearchMode mode, char **out_query) {
+    size_t len = strlen(text);
+    size_t chars = 0;
+    for (size_t i = 0; i < len; i += utf8_char_len((unsigned char)text[i])) {
+        chars++;
+    }
+    if (chars < 3) {
+        return BN_ERROR_INVALID_ARG;
+    }
+    
+    if (mode == SEARCH_MODE_SUBSTRING) {
+        // The whole text as one phrase: its trigrams must appear in sequence
+        char *query = malloc(len * 2 + 3);
+        if (!query) {
+            return BN_ERROR_OUT_OF_MEMORY;
+        }
+        *fts_append_quoted(query, text, len) = '\0';
+        *out_query = query;
+        return BN_SUCCESS;
+    }
+    
+    // Fuzzy: any trigram of the text may match; bm25 ranks the notes
+    // sharing the most trigrams first, which tolerates small typos
+    // Each quoted trigram is at most 12 bytes of text + 2 quotes, plus " OR "
+    char *query = malloc((chars - 2) * 18 + 1);
+    if (!query) {
+        return BN_ERROR_OUT_OF_MEMORY;
+    }
+    
+    char *out = query;
+    for (size_t start = 0; chars >= 3; chars--) {
+        size_t end = start;
+        for (int k = 0; k < 3 && end < len; k++) {
+            end += utf8_char_len((unsigned char)text[end]);
+        }
+        if (end > len) {
+            break;  // Truncated UTF-8 sequence at the end
+        }
+        if (out != query) {
+            memcpy(out, " OR ", 4);
+            out += 4;
+        }
+        out = fts_append_quoted(out, text + start, end - start);
+        start += utf8_char_len((unsigned char)text[start]);
+    }
+    *out = '\0';
+    
+    *out_query = query;
+    return BN_SUCCESS;
+}
+
+/* Bind the parameters shared by the ranked search statements; the
+ * weights (?2, ?7) are bound by the caller */
+static void bind_search(sqlite3_stmt *stmt, const char *match, const SearchOptions *opts,
+                        int snippet_tokens) {
+    sqlite3_bind_text(stmt, 1, match, -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 3, opts->mark_open ? opts->mark_open : "", -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 4, opts->mark_close ? opts->mark_close : "", -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int(stmt, 5, snippet_tokens);
+    sqlite3_bind_int(stmt, 6, opts->limit > 0 ? opts->limit : -1);
+}
+
+BnError db_note_search_ranked(Database *db, const char *query, const SearchOptions *opts,
+                              SearchCursor **out_cursor) {
+    if (!db || !db->handle || !query || !out_cursor) {
+        return BN_ERROR_INVALID_ARG;
+    }
+    
+    SearchOptions defaults;
+    if (!opts) {
+        db_search_options_init(&defaults);
+        opts = &defaults;
+    }
+    if (opts->limit < 0 || opts->snippet_tokens < 1 || opts->snippet_tokens > 64 ||
+        opts->mode < SEARCH_MODE_WORDS || opts->mode > SEARCH_MODE_FUZZY) {
+        return BN_ERROR_INVALID_ARG;
+    }
+    
+    const char *sql = SQL_NOTE_SEARCH_RANKED;
+    char *match = NULL;
+    BnError err;
+    
+    if (opts->mode != SEARCH_MODE_WORDS) {
+        int exists = 0;
+        err = schema_has_table(db->handle, "notes_trigram", &exists);
+        if (err != BN_SUCCESS) {
+            return err;
+        }
+        if (!exists) {
+            return BN_ERROR_NOT_FOUND;
+        }
+        
+        err = fts_trigram_query(query, opts->mode, &match);
+        if (err != BN_SUCCESS) {
+            return err;
+        }
+        sql = opts->mode == SEARCH_MODE_SUBSTRING ? SQL_NOTE_SEARCH_TRIGRAM : SQL_NOTE_SEARCH_FUZZY;
+    }
+    
+    SearchCursor *cursor = calloc(1, sizeof(SearchCursor));
+    if (!cursor) {
+        free(match);
+        return BN_ERROR_OUT_OF_MEMORY;
+    }
+    
+    err = db_stmt_acquire(db, sql, &cursor->stmt);
+    if (err != BN_SUCCESS) {
+        free(match);
+        free(cursor);
+        return err;
+    }
+    
+    // A trigram "token" is one character, so scale the snippet to roughly
+    // the same amount of text as in word mode
+    int snippet_tokens = opts->snippet_tokens;
+    if (opts->mode != SEARCH_MODE_WORDS) {
+        snippet_tokens = snippet_tokens * 4 < 64 ? snippet_tokens * 4 : 64;
+    }
+    bind_search(cursor->stmt, match ? match : query, opts, snippet_tokens);
+    sqlite3_bind_double(cursor->stmt, 2, opts->content_weight);
+    sqlite3_bind_double(cursor->stmt, 7, opts->title_weight);
+    free(match);
+    
+    cursor->db = db;
+    *out_cursor = cursor;
+    return BN_SUCCESS;
+}
+
+BnError db_search_cursor_next(SearchCursor *cursor, const SearchHit **out_hit) {
+    if (!cursor || !cursor->stmt || !out_hit) {
+        return BN_ERROR_INVALID_ARG;
+    }
+    
+    sqlite3_stmt *stmt = cursor->stmt;
+    int rc = sqlite3_step(stmt);
+    if (rc == SQLITE_ROW) {
+        SearchHit *hit = &cursor->row;
+        hit->note_id = sqlite3_column_int(stmt, 0);
+        hit->book_id = sqlite3_column_int(stmt, 1);
+        hit->page_number = sqlite3_column_int(stmt, 2);
+        hit->title = (const char *)sqlite3_column_text(stmt, 3);
+        hit->snippet = (const char *)sqlite3_column_text(stmt, 4);
+        hit->rank = sqlite3_column_double(stmt, 5);
+        hit->book_title = (const char *)sqlite3_column_text(stmt, 6);
+        *out_hit = hit;
+        return BN_SUCCESS;
+    }
+    
+    *out_hit = NULL;
+    return rc == SQLITE_DONE ? BN_SUCCESS : BN_ERROR_DATABASE;
+}
+
+void db_search_cursor_close(SearchCursor *cursor) {
+    if (!cursor) {
+        return;
+    }
+    
+    db_stmt_release(cursor->db, cursor->stmt);
+    free(cursor);
+}
+
+/* ============================================================================
+ * Library search
+ * ========================================================================= */
+
+// Per-source state of a library search cursor
+#define SOURCE_NEEDS_STEP 0     // Its last row was returned (or none read yet)
+#define SOURCE_HAS_ROW 1        // A row is waiting to be compared
+#define SOURCE_DONE 2
+
+BnError db_library_search(Database *db, const char *query, const SearchOptions *opts,
+                          LibrarySearchCursor **out_cursor) {
+    if (!db || !db->handle || !query || !out_cursor) {
+        return BN_ERROR_INVALID_ARG;
+    }
+    
+    SearchOptions defaults;
+    if (!opts) {
+        db_search_options_init(&defaults);
+        opts = &defaults;
+    }
+    if (opts->mode != SEARCH_MODE_WORDS || opts->limit < 0 ||
+        opts->snippet_tokens < 1 || opts->snippet_tokens > 64) {
+        return BN_ERROR_INVALID_ARG;
+    }
+    
+    LibrarySearchCursor *cursor = calloc(1, sizeof(LibrarySearchCursor));
+    if (!cursor) {
+        return BN_ERROR_OUT_OF_MEMORY;
+    }
+    
+    BnError err = db_stmt_acquire(db, SQL_LIBRARY_SEARCH_NOTES, &cursor->notes);
+    if (err == BN_SUCCESS) {
+        err = db_stmt_acquire(db, SQL_LIBRARY_SEARCH_PAGES, &cursor->pages);
+    }
+    if (err != BN_SUCCESS) {
+        db_stmt_release(db, cursor->notes);
+        free(cursor);
+        return err;
+    }
+    
+    // Either source alone may fill the limit, so each is asked for all of it
+    char rank[96];
+    bind_search(cursor->notes, query, opts, opts->snippet_tokens);
+    snprintf(rank, sizeof(rank), "bm25(%.6g, %.6g)", opts->title_weight, opts->content_weight);
+    sqlite3_bind_text(cursor->notes, 2, rank, -1, SQLITE_TRANSIENT);
+    
+    // Only the text column of pdf_pages_fts is indexed
+    bind_search(cursor->pages, query, opts, opts->snippet_tokens);
+    snprintf(rank, sizeof(rank), "bm25(0, 0, %.6g)", opts->content_weight);
+    sqlite3_bind_text(cursor->pages, 2, rank, -1, SQLITE_TRANSIENT);
+    
+    cursor->db = db;
+    cursor->notes_state = SOURCE_NEEDS_STEP;
+    cursor->pages_state = SOURCE_NEEDS_STEP;
+    cursor->remaining = opts->limit > 0 ? opts->limit : -1;
+    *out_cursor = cursor;
+    return BN_SUCCESS;
+}
+
+/* Step a source whose previous row has been handed out; the first row
+ * read is the source's best and sets the scale of its scores */
+static BnError library_source_advance(sqlite3_stmt *stmt, int rank_column, int *state, double *best) {
+    if (*state != SOURCE_NEEDS_STEP) {
+        return BN_SUCCESS;
+    }
+    
+    int rc = sqlite3_step(stmt);
+    if (rc == SQLITE_ROW) {
+        if (*best == 0.0) {
+            *best = sqlite3_column_double(stmt, rank_column);
+        }
+        *state = SOURCE_HAS_ROW;
+        return BN_SUCCESS;
+    }
+    
+    *state = SOURCE_DONE;
+    return rc == SQLITE_DONE ? BN_SUCCESS : BN_ERROR_DATABASE;
+}
+
+/* bm25() is negative, so the ratio is in (0, 1] with 1 for the best row */
+static double library_score(double rank, double best) {
+    return best < 0.0 ? rank / best : 1.0;
+}
+
+BnError db_library_search_next(LibrarySearchCursor *cursor, const LibraryHit **out_hit) {
+    if (!cursor || !cursor->notes || !cursor->pages || !out_hit) {
+        return BN_ERROR_INVALID_ARG;
+    }
+    
+    *out_hit = NULL;
+    if (cursor->remaining == 0) {
+        return BN_SUCCESS;
+    }
+    
+    BnError err = library_source_advance(cursor->notes, 5, &cursor->notes_state, &cursor->notes_best);
+    if (err == BN_SUCCESS) {
+        err = library_source_advance(cursor->pages, 3, &cursor->pages_state, &cursor->pages_best);
+    }
+    if (err != BN_SUCCESS) {
+        return err;
+    }
+    
+    int use_notes = cursor->notes_state == SOURCE_HAS_ROW;
+    int use_pages = cursor->pages_state == SOURCE_HAS_ROW;
+    if (!use_notes && !use_pages) {
+        return BN_SUCCESS;
+    }
+    double notes_score = use_notes ? library_score(sqlite3_column_double(cursor->notes, 5), cursor->notes_best) : 0.0;
+    double pages_score = use_pages ? library_score(sqlite3_column_double(cursor->pages, 3), cursor->pages_best) : 0.0;
+    
+    // Notes win ties
+    if (use_notes && use_pages) {
+        use_notes = notes_score >= pages_score;
+    }
+    
+    LibraryHit *hit = &cursor->row;
+    if (use_notes) {
+        sqlite3_stmt *stmt = cursor->notes;
+        hit->kind = LIBRARY_HIT_NOTE;
+        hit->note_id = sqlite3_column_int(stmt, 0);
+        hit->book_id = sqlite3_column_int(stmt, 1);
+        hit->page_number = sqlite3_column_int(stmt, 2);
+        hit->title = (const char *)sqlite3_column_text(stmt, 3);
+        hit->snippet = (const char *)sqlite3_column_text(stmt, 4);
+        hit->rank = sqlite3_column_double(stmt, 5);
+        hit->score = notes_score;
+        hit->book_title = (const char *)sqlite3_column_text(stmt, 6);
+        cursor->notes_state = SOURCE_NEEDS_STEP;
+    } else {
+        sqlite3_stmt *stmt = cursor->pages;
+        hit->kind = LIBRARY_HIT_PAGE;
+        hit->note_id = 0;
+        hit->book_id = sqlite3_column_int(stmt, 0);
+        hit->page_number = sqlite3_column_int(stmt, 1);
+        hit->title = NULL;
+        hit->snippet = (const char *)sqlite3_column_text(stmt, 2);
+        hit->rank = sqlite3_column_double(stmt, 3);
+        hit->score = pages_score;
+        hit->book_title = (const char *)sqlite3_column_text(stmt, 4);
+        cursor->pages_state = SOURCE_NEEDS_STEP;
+    }
+    
+    if (cursor->remaining > 0) {
+        cursor->remaining--;
+    }
+    *out_hit = hit;
+    return BN_SUCCESS;
+}
+
+void db_library_search_close(LibrarySearchCursor *cursor) {
+    if (!cursor) {
+        return;
+    }
+    
+    db_stmt_release(cursor->db, cursor->notes);
+    db_stmt_release(cursor->db, cursor->pages);
+    free(cursor);
+}
+
+/* ============================================================================
+ * PDF page text
+ * ========================================================================= */
+
+static int is_blank(const char *text) {
+    for (const char *p = text; *p; p++) {
+        if (!isspace((unsigned char)*p)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static BnError step_fingerprint_set(Database *db, int book_id, const PdfFingerprint *fingerprint) {
+    sqlite3_stmt *stmt;
+    BnError err = db_stmt_acquire(db,
+        "INSERT OR REPLACE INTO pdf_fingerprints (book_id, file_size, mtime_ns, hash, indexed_at) "
+        "VALUES (?, ?, ?, ?, ?);", &stmt);
+    if (err != BN_SUCCESS) {
+        return err;
+    }
+    
+    sqlite3_bind_int(stmt, 1, book_id);
+    sqlite3_bind_int64(stmt, 2, fingerprint->file_size);
+    sqlite3_bind_int64(stmt, 3, fingerprint->mtime_ns);
+    sqlite3_bind_int64(stmt, 4, fingerprint->hash);
+    sqlite3_bind_int64(stmt, 5, (sqlite3_int64)time(NULL));
+    
+    if (sqlite3_step(stmt) != SQLITE_DONE) {
+        err = write_error(db);
+    }
+    
+    db_stmt_release(db, stmt);
+    return err;
+}
+
+BnError db_pdf_pages_replace(Database *db, int book_id, const char *const *texts, int count,
+                             const PdfFingerprint *fingerprint, int *out_stored) {
+    if (!db || !db->handle || book_id <= 0 || (!texts && count > 0) || count < 0) {
+        return BN_ERROR_INVALID_ARG;
+    }
+    
+    BnError err = db_begin_transaction(db);
+    if (err != BN_SUCCESS) {
+        return err;
+    }
+    
+    sqlite3_stmt *stmt;
+    err = db_stmt_acquire(db, "DELETE FROM pdf_pages WHERE book_id = ?;", &stmt);
+    if (err == BN_SUCCESS) {
+        sqlite3_bind_int(stmt, 1, book_id);
+        if (sqlite3_step(stmt) != SQLITE_DONE) {
+            err = BN_ERROR_DATABASE;
+        }
+        db_stmt_release(db, stmt);
+    }
+    
+    int stored = 0;
+    if (err == BN_SUCCESS) {
+        err = db_stmt_acquire(db, "INSERT INTO pdf_pages (book_id, page, text) VALUES (?, ?, ?);", &stmt);
+    }
+    if (err == BN_SUCCESS) {
+        for (int i = 0; i < count && err == BN_SUCCESS; i++) {
+            if (!texts[i] || is_blank(texts[i])) {
+                continue;
+            }
+            
+            sqlite3_bind_int(stmt, 1, book_id);
+            sqlite3_bind_int(stmt, 2, i + 1);
+            sqlite3_bind_text(stmt, 3, texts[i], -1, SQLITE_STATIC);
+            
+            int rc = sqlite3_step(stmt);
+            if (rc == SQLITE_DONE) {
+                stored++;
+            } else {
+                err = write_error(db);
+            }
+            sqlite3_reset(stmt);
+        }
+        db_stmt_release(db, stmt);
+    }
+    
+    if (err == BN_SUCCESS && fingerprint) {
+        err = step_fingerprint_set(db, book_id, fingerprint);
+    }
+    
+    if (err != BN_SUCCESS) {
+        db_rollback_transaction(db);
+        return err;
+    }
+    
+    err = db_commit_transaction(db);
+    if (err != BN_SUCCESS) {
+        db_rollback_transaction(db);
+        return err;
+    }
+    
+    if (out_stored) {
+        *out_stored = stored;
+    }
+    return BN_SUCCESS;
+}
+
+BnError db_pdf_fingerprint_get(Database *db, int book_id, PdfFingerprint *out_fingerprint) {
+    if (!db || !db->handle || book_id <= 0 || !out_fingerprint) {
+        return BN_ERROR_INVALID_ARG;
+    }
+    
+    sqlite3_stmt *stmt;
+    BnError err = db_stmt_acquire(db,
+        "SELECT file_size, mtime_ns, hash FROM pdf_fingerprints WHERE book_id = ?;", &stmt);
+    if (err != BN_SUCCESS) {
+        return err;
+    }
+    sqlite3_bind_int(stmt, 1, book_id);
+    
+    int rc = sqlite3_step(stmt);
+    if (rc == SQLITE_ROW) {
+        out_fingerprint->file_size = sqlite3_column_int64(stmt, 0);
+        out_fingerprint->mtime_ns = sqlite3_column_int64(stmt, 1);
+        out_fingerprint->hash = sqlite3_column_int64(stmt, 2);
+    } else {
+        err = rc == SQLITE_DONE ? BN_ERROR_NOT_FOUND : BN_ERROR_DATABASE;
+    }
+    
+    db_stmt_release(db, stmt);
+    return err;
+}
+
+BnError db_pdf_fingerprint_set(Database *db, int book_id, const PdfFingerprint *fingerprint) {
+    if (!db || !db->handle || book_id <= 0 || !fingerprint) {
+        return BN_ERROR_INVALID_ARG;
+    }
+    
+    return step_fingerprint_set(db, book_id, fingerprint);
+}
+
+BnError db_pdf_pages_purge_orphans(Database *db, int *out_removed) {
+    if (!db || !db->handle) {
+        return BN_ERROR_INVALID_ARG;
+    }
+    
+    const char *statements[] = {
+        "DELETE FROM pdf_pages WHERE book_id NOT IN (SELECT id FROM books);",
+        "DELETE FROM pdf_fingerprints WHERE book_id NOT IN (SELECT id FROM books);",
+    };
+    
+    BnError err = db_begin_transaction(db);
+    if (err != BN_SUCCESS) {
+        return err;
+    }
+    
+    // sqlite3_changes leaves out the FTS rows deleted by triggers
+    int removed = 0;
+    for (size_t i = 0; i < sizeof(statements) / sizeof(statements[0]); i++) {
+        if (sqlite3_exec(db->handle, statements[i], NULL, NULL, NULL) != SQLITE_OK) {
+            db_rollback_transaction(db);
+            return BN_ERROR_DATABASE;
+        }
+        removed += sqlite3_changes(db->handle);
+    }
+    
+    err = db_commit_transaction(db);
+    if (err != BN_SUCCESS) {
+        db_rollback_transaction(db);
+        return err;
+    }
+    
+    if (out_removed) {
+        *out_removed = removed;
+    }
+    return BN_SUCCESS;
+}
+
+BnError db_pdf_pages_count(Database *db, int book_id, int *out_count) {
+    if (!db || !db->handle || !out_count || book_id <= 0) {
+        return BN_ERROR_INVALID_ARG;
+    }
+    
+    return count_query(db, "SELECT COUNT(*) FROM pdf_pages WHERE book_id = ?;", book_id, out_count);
+}
+
+/* ============================================================================
+ * Maintenance
+ * ========================================================================= */
+
+BnError db_fts_index_size(Database *db, long long *out_bytes) {
+    if (!db || !db->handle || !out_bytes) {
+        return BN_ERROR_INVALID_ARG;
+    }
+    
+    int has_trigram = 0;
+    BnError err = schema_has_table(db->handle, "notes_trigram", &has_trigram);
+    if (err != BN_SUCCESS) {
+        return err;
+    }
+    
+    // FTS5 keeps its inverted index in the <table>_data shadow tables
+    const char *sql = has_trigram ?
+        "SELECT (SELECT coalesce(sum(length(block)), 0) FROM notes_fts_data) + "
+        "(SELECT coalesce(sum(length(block)), 0) FROM books_fts_data) + "
+        "(SELECT coalesce(sum(length(block)), 0) FROM pdf_pages_fts_data) + "
+        "(SELECT coalesce(sum(length(block)), 0) FROM notes_trigram_data);" :
+        "SELECT (SELECT coalesce(sum(length(block)), 0) FROM notes_fts_data) + "
+        "(SELECT coalesce(sum(length(block)), 0) FROM books_fts_data) + "
+        "(SELECT coalesce(sum(length(block)), 0) FROM pdf_pages_fts_data);";
+    
+    sqlite3_stmt *stmt;
+    err = db_stmt_acquire(db, sql, &stmt);
+    if (err != BN_SUCCESS) {
+        return err;
+    }
+    
+    int rc = sqlite3_step(stmt);
+    if (rc == SQLITE_ROW) {
+        *out_bytes = sqlite3_column_int64(stmt, 0);
+    } else {
+        err = BN_ERROR_DATABASE;
+    }
+    
+    db_stmt_release(db, stmt);
+    return err;
+}
+
+BnError db_fts_set_substring_index(Database *db, int enabled) {
+    if (!db || !db->handle) {
+        return BN_ERROR_INVALID_ARG;
+    }
+    
+    return schema_set_trigram_index(db->handle, enabled);
+}
+
+BnError db_fts_reindex(Database *db) {
+    if (!db || !db->handle) {
+        return BN_ERROR_INVALID_ARG;
+    }
+    
+    int has_trigram = 0;
+    BnError err = schema_has_table(db->handle, "notes_trigram", &has_trigram);
+    if (err != BN_SUCCESS) {
+        return err;
+    }
+    
+    const char *sql =
+        "INSERT INTO notes_fts(notes_fts) VALUES ('rebuild');"
+        "INSERT INTO notes_fts(notes_fts) VALUES ('optimize');"
+        "INSERT INTO books_fts(books_fts) VALUES ('rebuild');"
+        "INSERT INTO books_fts(books_fts) VALUES ('optimize');"
+        "INSERT INTO pdf_pages_fts(pdf_pages_fts) VALUES ('rebuild');"
+        "INSERT INTO pdf_pages_fts(pdf_pages_fts) VALUES ('optimize');";
+    const char *trigram_sql =
+        "INSERT INTO notes_trigram(notes_trigram) VALUES ('rebuild');"
+        "INSERT INTO notes_trigram(notes_trigram) VALUES ('optimize');";
+    
+    err = db_begin_transaction(db);
+    if (err != BN_SUCCESS) {
+        return err;
+    }
+    
+    if (sqlite3_exec(db->handle, sql, NULL, NULL, NULL) != SQLITE_OK ||
+        (has_trigram && sqlite3_exec(db->handle, trigram_sql, NULL, NULL, NULL) != SQLITE_OK)) {
+        db_rollback_transaction(db);
+        return BN_ERROR_DATABASE;
+    }
+    
+    return db_commit_transaction(db);
+}
@@ -4,6 +4,19 @@
 #include "db.h"
 #include "../core/book.h"
 #include "../core/note.h"
+#include "../utils/arena.h"
+
+/*
+ * Threads: every function works on the connection it is given, which
+ * must not be used by another thread at the same time (see pool.h).
+ * 
+ * Safe on a read-only pool reader: *_get_*, *_count*, *_search*, the
+ * cursors, the statistics functions, db_note_from_json and
+ * db_fts_index_size.
+ * Writer only: *_insert*, *_update, *_delete, db_pdf_pages_replace,
+ * db_pdf_fingerprint_set, db_pdf_pages_purge_orphans,
+ * db_fts_set_substring_index and db_fts_reindex.
+ */
 
 /**
  * Book database operations
@@ -15,6 +28,19 @@
  */
 BnError db_book_insert(Database *db, Book *book);
 
+/**
+ * Insert many books in a single transaction
+ * Reuses one prepared statement for the whole batch and updates each
+ * book->id. A failing row does not abort the batch: its error is stored
+ * in row_errors[i] and the remaining rows are still inserted.
+ * 
+ * @param books Array of count books
+ * @param row_errors Optional array of count entries receiving per-row results
+ * @param out_inserted Optional pointer to store the number of rows inserted
+ * @return BN_SUCCESS if the batch committed, error code otherwise
+ */
+BnError db_book_insert_many(Database *db, Book **books, int count, BnError *row_errors, int *out_inserted);
+
 /**
  * Get book by ID
  */
@@ -22,7 +48,7 @@ BnError db_book_get_by_id(Database *db, int id, Book **out_book);
 
 /**
  * Get all books
- * Returns array of Book pointers, NULL-terminated
+ * Returns array of out_count Book pointers (NULL if the library is empty)
  */
 BnError db_book_get_all(Database *db, Book ***out_books, int *out_count);
 
@@ -47,6 +73,23 @@ BnError db_book_delete(Database *db, int id);
  */
 BnError db_note_insert(Database *db, Note *note);
 
+/**
+ * Insert many notes in a single transaction
+ * Same contract as db_book_insert_many. Rows referencing a missing book
+ * fail with BN_ERROR_NOT_FOUND.
+ */
+BnError db_note_insert_many(Database *db, Note **notes, int count, BnError *row_errors, int *out_inserted);
+
+/**
+ * Parse a note from a JSON object
+ * Accepts {"book_id": N, "content": "...", "title": "...", "page": N};
+ * title and page are optional ("page_number" is accepted for page).
+ * 
+ * @param out_note Pointer to store the new (unsaved) note
+ * @return BN_SUCCESS on success, BN_ERROR_INVALID_ARG for malformed input
+ */
+BnError db_note_from_json(Database *db, const char *json, Note **out_note);
+
 /**
  * Get note by ID
  */
@@ -72,4 +115,562 @@ BnError db_note_delete(Database *db, int id);
  */
 BnError db_note_search(Database *db, const char *query, Note ***out_notes, int *out_count);
 
+/**
+ * Arena-backed result sets
+ *
+ * All strings of a result set are copied into a single arena and the rows
+ * are stored contiguously, so a whole result is released with one call
+ * instead of a book_free/note_free per row. Rows must not be passed to
+ * book_free/note_free.
+ */
+
+/**
+ * Book result set
+ */
+typedef struct {
+    Book *books;        // Contiguous array of count rows
+    int count;
+    int capacity;
+    Arena arena;        // Owns every string referenced by the rows
+} BookResultSet;
+
+/**
+ * Note result set
+ */
+typedef struct {
+    Note *notes;        // Contiguous array of count rows
+    int count;
+    int capacity;
+    Arena arena;        // Owns every string referenced by the rows
+} NoteResultSet;
+
+/**
+ * Get all books into an arena-backed result set
+ */
+BnError db_book_get_all_arena(Database *db, BookResultSet **out_set);
+
+/**
+ * Get all notes for a book into an arena-backed result set
+ */
+BnError db_note_get_by_book_arena(Database *db, int book_id, NoteResultSet **out_set);
+
+/**
+ * Search notes (FTS) into an arena-backed result set
+ */
+BnError db_note_search_arena(Database *db, const char *query, NoteResultSet **out_set);
+
+/**
+ * Keyset pagination
+ * 
+ * A page starts strictly after the row whose id is after_id (0 for the
+ * first page) in the chosen sort order and holds at most limit rows.
+ * Pass the id of the last row of a page to fetch the next one; each page
+ * is an index range scan, so latency does not grow with the page number.
+ * If after_id no longer exists the page is empty.
+ */
+
+/**
+ * Book sort keys
+ */
+typedef enum {
+    BOOK_SORT_TITLE = 0,    // Title (case-insensitive), then id
+    BOOK_SORT_ADDED         // Insertion order (id)
+} BookSort;
+
+/**
+ * Note sort keys
+ */
+typedef enum {
+    NOTE_SORT_CREATED = 0,  // Creation time, then id
+    NOTE_SORT_PAGE          // Page number (unpaged notes first), then id; sorts the
+                            // book's notes per page instead of walking an index
+} NoteSort;
+
+/**
+ * Get one page of books into an arena-backed result set
+ * 
+ * @param sort Sort key
+ * @param after_id Id of the last row of the previous page, 0 for the first page
+ * @param limit Maximum number of rows (> 0)
+ */
+BnError db_book_get_page(Database *db, BookSort sort, int after_id, int limit, BookResultSet **out_set);
+
+/**
+ * Get one page of a book's notes into an arena-backed result set
+ * Same contract as db_book_get_page.
+ */
+BnError db_note_get_page_by_book(Database *db, int book_id, NoteSort sort, int after_id, int limit,
+                                 NoteResultSet **out_set);
+
+/**
+ * Flags of db_fts_word_query
+ */
+#define DB_FTS_PREFIX_LAST 0x1      // Match the last term as a prefix (search as you type)
+#define DB_FTS_PREFIX_ALL  0x2      // Match every term as a prefix
+#define DB_FTS_OPERATORS   0x4      // Keep AND, OR, NOT and NEAR between terms
+
+/**
+ * Build an FTS5 query from typed words
+ * Each word is quoted, with embedded quotes doubled, so punctuation such
+ * as "c++" is never query syntax; a word ending in * is matched as a
+ * prefix. Text in balanced double quotes is one phrase ("quantum
+ * mechanics", or "quantum mech"* as a prefix); an unbalanced quote is
+ * literal. Every term must match.
+ * 
+ * With DB_FTS_OPERATORS, an uppercase AND, OR or NOT between two terms
+ * stays an operator, and a NEAR b becomes NEAR(a b). Anywhere else they
+ * are ordinary words, except one at the very end, which is dropped while
+ * it is still being typed. The result is always valid FTS5.
+ * 
+ * @param text Typed text
+ * @param flags DB_FTS_* flags
+ * @param out_query Pointer to store the query (free with free())
+ * @return BN_SUCCESS on success, BN_ERROR_INVALID_ARG if text has no words
+ */
+BnError db_fts_word_query(const char *text, int flags, char **out_query);
+
+/**
+ * Search books by title, author, publisher or ISBN (FTS)
+ * Every whitespace-separated word of text is matched as a prefix, so
+ * "knu art" finds "The Art of Computer Programming" by Knuth. Results are
+ * ranked by relevance, title matches first.
+ * 
+ * @param text Free text (not FTS5 syntax)
+ * @param limit Maximum number of books, 0 for all
+ * @param out_set Pointer to store the result set
+ */
+BnError db_book_search(Database *db, const char *text, int limit, BookResultSet **out_set);
+
+/**
+ * Free a result set and every row in it
+ */
+void db_book_result_free(BookResultSet *set);
+void db_note_result_free(NoteResultSet *set);
+
+/**
+ * Count operations
+ */
+
+/**
+ * Count books in the library
+ */
+BnError db_book_count(Database *db, int *out_count);
+
+/**
+ * Count notes for a book
+ */
+BnError db_note_count_by_book(Database *db, int book_id, int *out_count);
+
+/**
+ * Statistics
+ * 
+ * Each function is a single aggregate query: rows are counted and summed
+ * inside SQLite instead of being loaded. Word counts split note content
+ * on whitespace (the word_count() SQL function registered by db_open).
+ */
+
+/**
+ * Library-wide totals
+ */
+typedef struct {
+    int books;
+    int notes;
+    int paged_notes;            // Notes with a page number
+    long long words;            // Words in all notes
+    long long last_updated;     // Latest book or note update, 0 if empty
+} LibraryTotals;
+
+/**
+ * Note count of one book
+ */
+typedef struct {
+    int book_id;
+    int note_count;
+} BookNoteCount;
+
+/**
+ * Per-book statistics
+ */
+typedef struct {
+    int book_id;
+    const char *title;          // Owned by the set's arena
+    int note_count;
+    long long word_count;
+    long long last_updated;     // Latest of the book's and its notes' updated_at
+} BookStats;
+
+/**
+ * Per-book statistics result set
+ */
+typedef struct {
+    BookStats *rows;            // Contiguous array of count rows
+    int count;
+    int capacity;
+    Arena arena;                // Owns every title
+} BookStatsSet;
+
+/**
+ * Per-book statistics sort keys (ties broken by id)
+ */
+typedef enum {
+    BOOK_STATS_BY_NOTES = 0,    // Most notes first
+    BOOK_STATS_BY_WORDS,        // Most words first
+    BOOK_STATS_BY_UPDATED       // Most recently updated first
+} BookStatsSort;
+
+/**
+ * Note count of a range of pages
+ */
+typedef struct {
+    int first_page;
+    int last_page;
+    int note_count;
+} PageRangeCount;
+
+/**
+ * Get library-wide totals
+ */
+BnError db_library_totals(Database *db, LibraryTotals *out_totals);
+
+/**
+ * Get the note count of every book that has notes, ordered by book id
+ * Covered by the notes(book_id, ...) index, so no note is read.
+ * 
+ * @param out_counts Pointer to store an array of out_count entries (caller
+ *                   must free; NULL if there are no notes)
+ */
+BnError db_note_counts_by_book(Database *db, BookNoteCount **out_counts, int *out_count);
+
+/**
+ * Get per-book note count, word count and last update
+ * Books without notes are included with zero counts.
+ * 
+ * @param sort Sort key
+ * @param limit Maximum number of books, 0 for all
+ * @param out_set Pointer to store the result set (free with db_book_stats_free)
+ */
+BnError db_book_stats(Database *db, BookStatsSort sort, int limit, BookStatsSet **out_set);
+
+/**
+ * Free a per-book statistics result set
+ */
+void db_book_stats_free(BookStatsSet *set);
+
+/**
+ * Count a book's notes per range of pages
+ * Ranges are bucket_size pages wide (1-50, 51-100, ...); only ranges with
+ * notes are returned, in page order. Notes without a page are not counted.
+ * 
+ * @param book_id Book to count
+ * @param bucket_size Pages per range (> 0)
+ * @param out_ranges Pointer to store an array of out_count ranges (caller
+ *                   must free; NULL if no note has a page)
+ */
+BnError db_note_page_ranges(Database *db, int book_id, int bucket_size,
+                            PageRangeCount **out_ranges, int *out_count);
+
+/**
+ * Streaming cursors
+ *
+ * Cursors step the underlying statement lazily and yield borrowed rows:
+ * string fields point into SQLite's buffers and are only valid until the
+ * next call to *_cursor_next or *_cursor_close. Copy anything you keep.
+ * Do not write to the tables being iterated while a cursor is open.
+ */
+
+/**
+ * Book cursor (ordered by title)
+ */
+typedef struct {
+    Database *db;
+    sqlite3_stmt *stmt;
+    Book row;           // Borrowed row returned by db_book_cursor_next
+} BookCursor;
+
+/**
+ * Note cursor
+ */
+typedef struct {
+    Database *db;
+    sqlite3_stmt *stmt;
+    Note row;           // Borrowed row returned by db_note_cursor_next
+} NoteCursor;
+
+/**
+ * Open cursor over all books in sort order
+ */
+BnError db_book_cursor_open(Database *db, BookSort sort, BookCursor **out_cursor);
+
+/**
+ * Advance cursor
+ * Sets *out_book to the next row, or NULL when the cursor is exhausted
+ */
+BnError db_book_cursor_next(BookCursor *cursor, const Book **out_book);
+
+/**
+ * Close cursor and release its statement
+ */
+void db_book_cursor_close(BookCursor *cursor);
+
+/**
+ * Open cursor over the notes of a book in sort order
+ */
+BnError db_note_cursor_open_by_book(Database *db, int book_id, NoteSort sort, NoteCursor **out_cursor);
+
+/**
+ * Open cursor over notes matching an FTS query (newest first)
+ */
+BnError db_note_cursor_open_search(Database *db, const char *query, NoteCursor **out_cursor);
+
+/**
+ * Advance cursor
+ * Sets *out_note to the next row, or NULL when the cursor is exhausted
+ */
+BnError db_note_cursor_next(NoteCursor *cursor, const Note **out_note);
+
+/**
+ * Close cursor and release its statement
+ */
+void db_note_cursor_close(NoteCursor *cursor);
+
+/**
+ * Ranked search
+ * 
+ * Hits are ordered by bm25() relevance (best first) and carry a short
+ * snippet of the matching text instead of the whole note body. Like the
+ * other cursors, hits are borrowed and only valid until the next call.
+ */
+
+/**
+ * How the query text is matched
+ */
+typedef enum {
+    SEARCH_MODE_WORDS = 0,      // FTS5 query over whole words (notes_fts)
+    SEARCH_MODE_SUBSTRING,      // Literal text anywhere, even inside words (notes_trigram)
+    SEARCH_MODE_FUZZY           // Notes sharing the most trigrams with the text first
+                                // (tolerates typos; the snippet is the start of the note)
+} SearchMode;
+
+/**
+ * Ranked search options
+ */
+typedef struct {
+    SearchMode mode;
+    int limit;                  // Maximum number of hits, 0 for all
+    double title_weight;        // bm25() weight of the title column
+    double content_weight;      // bm25() weight of the content column
+    const char *mark_open;      // Inserted before each matched term
+    const char *mark_close;     // Inserted after each matched term
+    int snippet_tokens;         // Approximate snippet length in tokens (1-64)
+} SearchOptions;
+
+/**
+ * Search hit
+ */
+typedef struct {
+    int note_id;
+    int book_id;
+    int page_number;
+    const char *title;          // Note title
+    const char *snippet;        // Matching context with marked terms
+    double rank;                // bm25() score, lower is more relevant
+    const char *book_title;     // Title of the book the note belongs to
+} SearchHit;
+
+/**
+ * Search cursor
+ */
+typedef struct {
+    Database *db;
+    sqlite3_stmt *stmt;
+    SearchHit row;              // Borrowed row returned by db_search_cursor_next
+} SearchCursor;
+
+/**
+ * Fill opts with the defaults: word search, 50 hits, titles weighted 2x content,
+ * [ ] markers, 16-token snippets
+ */
+void db_search_options_init(SearchOptions *opts);
+
+/**
+ * Open a ranked search over notes
+ * 
+ * In SEARCH_MODE_WORDS the query uses FTS5 syntax (build it from typed text
+ * with db_fts_word_query). The trigram modes take
+ * plain text of at least three characters and return BN_ERROR_NOT_FOUND
+ * unless the substring index was enabled with db_fts_set_substring_index.
+ * 
+ * @param query FTS5 query or plain text, depending on opts->mode
+ * @param opts Search options, or NULL for the defaults
+ * @param out_cursor Pointer to store the cursor
+ * @return BN_SUCCESS on success, error code otherwise
+ */
+BnError db_note_search_ranked(Database *db, const char *query, const SearchOptions *opts,
+                              SearchCursor **out_cursor);
+
+/**
+ * Advance cursor
+ * Sets *out_hit to the next hit, or NULL when the cursor is exhausted
+ */
+BnError db_search_cursor_next(SearchCursor *cursor, const SearchHit **out_hit);
+
+/**
+ * Close cursor and release its statement
+ */
+void db_search_cursor_close(SearchCursor *cursor);
+
+/**
+ * Library search
+ * 
+ * One ranked list of notes and indexed PDF pages (see db_pdf_pages_replace).
+ * Each source returns only its own best opts->limit hits, already sorted,
+ * and the cursor merges the two streams as it is read: the snippets and
+ * joins are computed for those hits only, and reading stops after the
+ * limit.
+ * 
+ * bm25() depends on each index's term statistics and document lengths,
+ * so raw scores of notes and pages are not comparable. Each hit is scored
+ * relative to the best hit of its own source instead (1.0 for the best,
+ * towards 0 for weaker ones) and the streams are merged on that score:
+ * both sources lead with their best hit and interleave by how close the
+ * rest come to it.
+ */
+
+/**
+ * Source of a library search hit
+ */
+typedef enum {
+    LIBRARY_HIT_NOTE = 0,
+    LIBRARY_HIT_PAGE
+} LibraryHitKind;
+
+/**
+ * Library search hit
+ */
+typedef struct {
+    LibraryHitKind kind;
+    int note_id;                // 0 for page hits
+    int book_id;
+    int page_number;            // 1-based page, 0 for a note without one
+    const char *title;          // Note title, NULL for page hits
+    const char *snippet;        // Matching context with marked terms
+    double rank;                // bm25() score, lower is more relevant
+    double score;               // rank / best rank of its source, higher is more relevant
+    const char *book_title;
+} LibraryHit;
+
+/**
+ * Library search cursor
+ */
+typedef struct {
+    Database *db;
+    sqlite3_stmt *notes;
+    sqlite3_stmt *pages;
+    int notes_state;            // Whether the source has a row waiting, needs a step or is done
+    int pages_state;
+    double notes_best;          // Rank of each source's first (best) row, 0 until read
+    double pages_best;
+    int remaining;              // Hits left before the limit, -1 for no limit
+    LibraryHit row;             // Borrowed row returned by db_library_search_next
+} LibrarySearchCursor;
+
+/**
+ * Open a ranked search over notes and PDF page text
+ * 
+ * Only SEARCH_MODE_WORDS is supported (page text has no substring index).
+ * 
+ * @param query FTS5 query
+ * @param opts Search options, or NULL for the defaults; opts->limit bounds
+ *             the merged list
+ * @param out_cursor Pointer to store the cursor
+ * @return BN_SUCCESS on success, BN_ERROR_INVALID_ARG for another mode,
+ *         error code otherwise
+ */
+BnError db_library_search(Database *db, const char *query, const SearchOptions *opts,
+                          LibrarySearchCursor **out_cursor);
+
+/**
+ * Advance cursor
+ * Sets *out_hit to the next best hit of either source, or NULL when done
+ */
+BnError db_library_search_next(LibrarySearchCursor *cursor, const LibraryHit **out_hit);
+
+/**
+ * Close cursor and release its statements
+ */
+void db_library_search_close(LibrarySearchCursor *cursor);
+
+/**
+ * PDF page text
+ */
+
+/**
+ * Fingerprint of a PDF file as of its last indexing
+ */
+typedef struct {
+    long long file_size;
+    long long mtime_ns;
+    long long hash;             // Hash of the first and last blocks
+} PdfFingerprint;
+
+/**
+ * Replace the stored text of a book's PDF
+ * Deletes the book's pages and inserts texts[i] as page i + 1, skipping
+ * NULL or blank pages. The fingerprint is stored in the same transaction,
+ * so it never describes pages that were not written.
+ * 
+ * @param texts Array of count page texts (may contain NULL)
+ * @param fingerprint Fingerprint of the file the texts came from, or NULL
+ * @param out_stored Optional pointer to store the number of pages stored
+ */
+BnError db_pdf_pages_replace(Database *db, int book_id, const char *const *texts, int count,
+                             const PdfFingerprint *fingerprint, int *out_stored);
+
+/**
+ * Get the fingerprint stored for a book
+ * @return BN_SUCCESS, or BN_ERROR_NOT_FOUND if the book was never indexed
+ */
+BnError db_pdf_fingerprint_get(Database *db, int book_id, PdfFingerprint *out_fingerprint);
+
+/**
+ * Update the stored fingerprint of a book without touching its pages
+ * (e.g. the file was touched but its content is unchanged)
+ */
+BnError db_pdf_fingerprint_set(Database *db, int book_id, const PdfFingerprint *fingerprint);
+
+/**
+ * Delete pages and fingerprints whose book no longer exists
+ * Deleting a book cascades, but rows can be left behind by databases
+ * edited with foreign keys off.
+ * 
+ * @param out_removed Optional pointer to store the number of rows deleted
+ */
+BnError db_pdf_pages_purge_orphans(Database *db, int *out_removed);
+
+/**
+ * Count the pages stored for a book
+ */
+BnError db_pdf_pages_count(Database *db, int book_id, int *out_count);
+
+/**
+ * Maintenance
+ */
+
+/**
+ * Get the size of the full-text indexes (notes, books and PDF pages) in bytes
+ */
+BnError db_fts_index_size(Database *db, long long *out_bytes);
+
+/**
+ * Enable (build) or disable (drop) the trigram index used by substring
+ * and fuzzy search
+ */
+BnError db_fts_set_substring_index(Database *db, int enabled);
+
+/**
+ * Rebuild the full-text indexes from their tables and merge them into a
+ * single segment each ('rebuild' + 'optimize'), in one transaction
+ */
+BnError db_fts_reindex(Database *db);
+
 #endif // BOOKNOTE_QUERIES_H
@@ -1,7 +1,9 @@
+#define _POSIX_C_SOURCE 200809L
 #include "schema.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <time.h>
 
 const char *SQL_CREATE_BOOKS_TABLE =
     "CREATE TABLE IF NOT EXISTS books ("
@@ -31,22 +33,125 @@ const char *SQL_CREATE_NOTES_TABLE =
 
 const char *SQL_CREATE_NOTES_FTS =
     "CREATE VIRTUAL TABLE IF NOT EXISTS notes_fts USING fts5("
+    "  title,"
     "  content,"
     "  content=notes,"
     "  content_rowid=id"
     ");";
 
+// External-content FTS5 rows cannot be UPDATEd or DELETEd directly: the
+// old tokens must be removed with the 'delete' command, then re-inserted
 const char *SQL_CREATE_FTS_TRIGGERS =
     "CREATE TRIGGER IF NOT EXISTS notes_ai AFTER INSERT ON notes BEGIN "
-    "  INSERT INTO notes_fts(rowid, content) VALUES (new.id, new.content);"
+    "  INSERT INTO notes_fts(rowid, title, content) VALUES (new.id, new.title, new.content);"
     "END;"
     "CREATE TRIGGER IF NOT EXISTS notes_ad AFTER DELETE ON notes BEGIN "
-    "  DELETE FROM notes_fts WHERE rowid = old.id;"
+    "  INSERT INTO notes_fts(notes_fts, rowid, title, content) "
+    "  VALUES ('delete', old.id, old.title, old.content);"
     "END;"
     "CREATE TRIGGER IF NOT EXISTS notes_au AFTER UPDATE ON notes BEGIN "
-    "  UPDATE notes_fts SET content = new.content WHERE rowid = new.id;"
+    "  INSERT INTO notes_fts(notes_fts, rowid, title, content) "
+    "  VALUES ('delete', old.id, old.title, old.content);"
+    "  INSERT INTO notes_fts(rowid, title, content) VALUES (new.id, new.title, new.content);"
     "END;";
 
+const char *SQL_CREATE_BOOKS_FTS =
+    "CREATE VIRTUAL TABLE IF NOT EXISTS books_fts USING fts5("
+    "  title,"
+    "  author,"
+    "  publisher,"
+    "  isbn,"
+    "  content=books,"
+    "  content_rowid=id,"
+    "  prefix='2 3'"
+    ");";
+
+const char *SQL_CREATE_BOOKS_FTS_TRIGGERS =
+    "CREATE TRIGGER IF NOT EXISTS books_ai AFTER INSERT ON books BEGIN "
+    "  INSERT INTO books_fts(rowid, title, author, publisher, isbn) "
+    "  VALUES (new.id, new.title, new.author, new.publisher, new.isbn);"
+    "END;"
+    "CREATE TRIGGER IF NOT EXISTS books_ad AFTER DELETE ON books BEGIN "
+    "  INSERT INTO books_fts(books_fts, rowid, title, author, publisher, isbn) "
+    "  VALUES ('delete', old.id, old.title, old.author, old.publisher, old.isbn);"
+    "END;"
+    "CREATE TRIGGER IF NOT EXISTS books_au AFTER UPDATE ON books BEGIN "
+    "  INSERT INTO books_fts(books_fts, rowid, title, author, publisher, isbn) "
+    "  VALUES ('delete', old.id, old.title, old.author, old.publisher, old.isbn);"
+    "  INSERT INTO books_fts(rowid, title, author, publisher, isbn) "
+    "  VALUES (new.id, new.title, new.author, new.publisher, new.isbn);"
+    "END;";
+
+const char *SQL_CREATE_NOTES_TRIGRAM =
+    "CREATE VIRTUAL TABLE IF NOT EXISTS notes_trigram USING fts5("
+    "  title,"
+    "  content,"
+    "  content=notes,"
+    "  content_rowid=id,"
+    "  tokenize='trigram'"
+    ");";
+
+const char *SQL_CREATE_TRIGRAM_TRIGGERS =
+    "CREATE TRIGGER IF NOT EXISTS notes_trigram_ai AFTER INSERT ON notes BEGIN "
+    "  INSERT INTO notes_trigram(rowid, title, content) VALUES (new.id, new.title, new.content);"
+    "END;"
+    "CREATE TRIGGER IF NOT EXISTS notes_trigram_ad AFTER DELETE ON notes BEGIN "
+    "  INSERT INTO notes_trigram(notes_trigram, rowid, title, content) "
+    "  VALUES ('delete', old.id, old.title, old.content);"
+    "END;"
+    "CREATE TRIGGER IF NOT EXISTS notes_trigram_au AFTER UPDATE ON notes BEGIN "
+    "  INSERT INTO notes_trigram(notes_trigram, rowid, title, content) "
+    "  VALUES ('delete', old.id, old.title, old.content);"
+    "  INSERT INTO notes_trigram(rowid, title, content) VALUES (new.id, new.title, new.content);"
+    "END;";
+
+const char *SQL_CREATE_PDF_PAGES_TABLE =
+    "CREATE TABLE IF NOT EXISTS pdf_pages ("
+    "  id INTEGER PRIMARY KEY,"
+    "  book_id INTEGER NOT NULL,"
+    "  page INTEGER NOT NULL,"
+    "  text TEXT NOT NULL,"
+    "  UNIQUE (book_id, page),"
+    "  FOREIGN KEY (book_id) REFERENCES books(id) ON DELETE CASCADE"
+    ");";
+
+const char *SQL_CREATE_PDF_PAGES_FTS =
+    "CREATE VIRTUAL TABLE IF NOT EXISTS pdf_pages_fts USING fts5("
+    "  book_id UNINDEXED,"
+    "  page UNINDEXED,"
+    "  text,"
+    "  content=pdf_pages,"
+    "  content_rowid=id"
+    ");";
+
+const char *SQL_CREATE_PDF_PAGES_FTS_TRIGGERS =
+    "CREATE TRIGGER IF NOT EXISTS pdf_pages_ai AFTER INSERT ON pdf_pages BEGIN "
+    "  INSERT INTO pdf_pages_fts(rowid, book_id, page, text) VALUES (new.id, new.book_id, new.page, new.text);"
+    "END;"
+    "CREATE TRIGGER IF NOT EXISTS pdf_pages_ad AFTER DELETE ON pdf_pages BEGIN "
+    "  INSERT INTO pdf_pages_fts(pdf_pages_fts, rowid, book_id, page, text) "
+    "  VALUES ('delete', old.id, old.book_id, old.page, old.text);"
+    "END;"
+    "CREATE TRIGGER IF NOT EXISTS pdf_pages_au AFTER UPDATE ON pdf_pages BEGIN "
+    "  INSERT INTO pdf_pages_fts(pdf_pages_fts, rowid, book_id, page, text) "
+    "  VALUES ('delete', old.id, old.book_id, old.page, old.text);"
+    "  INSERT INTO pdf_pages_fts(rowid, book_id, page, text) VALUES (new.id, new.book_id, new.page, new.text);"
+    "END;";
+
+const char *SQL_CREATE_PDF_FINGERPRINTS_TABLE =
+    "CREATE TABLE IF NOT EXISTS pdf_fingerprints ("
+    "  book_id INTEGER PRIMARY KEY,"
+    "  file_size INTEGER NOT NULL,"
+    "  mtime_ns INTEGER NOT NULL,"
+    "  hash INTEGER NOT NULL,"
+    "  indexed_at INTEGER NOT NULL,"
+    "  FOREIGN KEY (book_id) REFERENCES books(id) ON DELETE CASCADE"
+    ");";
+
+const char *SQL_CREATE_INDEXES =
+    "CREATE INDEX IF NOT EXISTS idx_notes_book_created ON notes(book_id, created_at);"
+    "CREATE INDEX IF NOT EXISTS idx_books_title_nocase ON books(title COLLATE NOCASE);";
+
 const char *SQL_CREATE_METADATA_TABLE =
     "CREATE TABLE IF NOT EXISTS metadata ("
     "  key TEXT PRIMARY KEY,"
@@ -68,43 +173,105 @@ static BnError execute_sql(sqlite3 *db, const char *sql) {
     return BN_SUCCESS;
 }
 
-static BnError migrate_to_v2(sqlite3 *db) {
-    printf("Migrating database to version 2...\n");
-    
-    // Add title column to notes table
-    const char *sql = "ALTER TABLE notes ADD COLUMN title TEXT NOT NULL DEFAULT 'Untitled';";
-    
-    BnError err = execute_sql(db, sql);
-    if (err != BN_SUCCESS) {
+BnError schema_set_trigram_index(sqlite3 *db, int enabled) {
+    if (!db) {
+        return BN_ERROR_INVALID_ARG;
+    }
+
+    int exists = 0;
+    BnError err = schema_has_table(db, "notes_trigram", &exists);
+    if (err != BN_SUCCESS || exists == !!enabled) {
         return err;
     }
-    
-    // Update schema version
-    const char *update_version = "UPDATE metadata SET value = '2' WHERE key = 'schema_version';";
-    err = execute_sql(db, update_version);
+
+    err = execute_sql(db, "BEGIN;");
+    if (err != BN_SUCCESS) return err;
+
+    if (enabled) {
+        // Fails with "no such tokenizer" before SQLite 3.34
+        err = execute_sql(db, SQL_CREATE_NOTES_TRIGRAM);
+        if (err == BN_SUCCESS) {
+            err = execute_sql(db, SQL_CREATE_TRIGRAM_TRIGGERS);
+        }
+        if (err == BN_SUCCESS) {
+            err = execute_sql(db, "INSERT INTO notes_trigram(notes_trigram) VALUES ('rebuild');");
+        }
+    } else {
+        err = execute_sql(db,
+            "DROP TRIGGER IF EXISTS notes_trigram_ai;"
+            "DROP TRIGGER IF EXISTS notes_trigram_ad;"
+            "DROP TRIGGER IF EXISTS notes_trigram_au;"
+            "DROP TABLE IF EXISTS notes_trigram;");
+    }
+
     if (err != BN_SUCCESS) {
+        execute_sql(db, "ROLLBACK;");
         return err;
     }
-    
-    printf("Migration to v2 complete\n");
-    return BN_SUCCESS;
+    return execute_sql(db, "COMMIT;");
 }
 
-BnError schema_initialize(sqlite3 *db) {
-    if (!db) {
+BnError schema_has_table(sqlite3 *db, const char *name, int *out_exists) {
+    if (!db || !name || !out_exists) {
         return BN_ERROR_INVALID_ARG;
     }
 
-    BnError err;
+    const char *sql = "SELECT 1 FROM sqlite_master WHERE type = 'table' AND name = ?;";
+    sqlite3_stmt *stmt;
+
+    int rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+    if (rc != SQLITE_OK) {
+        return BN_ERROR_DATABASE;
+    }
+
+    sqlite3_bind_text(stmt, 1, name, -1, SQLITE_STATIC);
+    rc = sqlite3_step(stmt);
+    sqlite3_finalize(stmt);
+
+    if (rc != SQLITE_ROW && rc != SQLITE_DONE) {
+        return BN_ERROR_DATABASE;
+    }
+
+    *out_exists = (rc == SQLITE_ROW);
+    return BN_SUCCESS;
+}
+
+/* ============================================================================
+ * Migrations
+ * ========================================================================= */
+
+// Legacy steps: each brings a database from version - 1 to version
+static BnError migrate_v2(sqlite3 *db) {
+    return execute_sql(db, "ALTER TABLE notes ADD COLUMN title TEXT NOT NULL DEFAULT 'Untitled';");
+}
+
+static BnError migrate_v3(sqlite3 *db) {
+    return execute_sql(db, "ALTER TABLE books ADD COLUMN cover_path TEXT;");
+}
+
+static BnError migrate_v4(sqlite3 *db) {
+    // Index the notes-by-book and title-sorted access paths
+    return execute_sql(db, SQL_CREATE_INDEXES);
+}
 
-    // Create tables
-    err = execute_sql(db, SQL_CREATE_BOOKS_TABLE);
+static BnError migrate_v5(sqlite3 *db) {
+    // Index the existing catalog for `find`
+    BnError err = execute_sql(db, SQL_CREATE_BOOKS_FTS);
     if (err != BN_SUCCESS) return err;
 
-    err = execute_sql(db, SQL_CREATE_NOTES_TABLE);
+    err = execute_sql(db, SQL_CREATE_BOOKS_FTS_TRIGGERS);
     if (err != BN_SUCCESS) return err;
 
-    err = execute_sql(db, SQL_CREATE_METADATA_TABLE);
+    return execute_sql(db, "INSERT INTO books_fts(books_fts) VALUES ('rebuild');");
+}
+
+static BnError migrate_v6(sqlite3 *db) {
+    // Recreate notes_fts with the title column and delete+insert triggers
+    BnError err = execute_sql(db,
+        "DROP TRIGGER IF EXISTS notes_ai;"
+        "DROP TRIGGER IF EXISTS notes_ad;"
+        "DROP TRIGGER IF EXISTS notes_au;"
+        "DROP TABLE IF EXISTS notes_fts;");
     if (err != BN_SUCCESS) return err;
 
     err = execute_sql(db, SQL_CREATE_NOTES_FTS);
@@ -113,39 +280,243 @@ BnError schema_initialize(sqlite3 *db) {
     err = execute_sql(db, SQL_CREATE_FTS_TRIGGERS);
     if (err != BN_SUCCESS) return err;
 
-    // Set schema version if not exists (for new databases)
-    const char *insert_version =
-        "INSERT OR IGNORE INTO metadata (key, value) VALUES ('schema_version', '3');";
-    err = execute_sql(db, insert_version);
+    return execute_sql(db, "INSERT INTO notes_fts(notes_fts) VALUES ('rebuild');");
+}
+
+static BnError migrate_v7(sqlite3 *db) {
+    // Empty until `booknote index-pdf` runs
+    BnError err = execute_sql(db, SQL_CREATE_PDF_PAGES_TABLE);
+    if (err != BN_SUCCESS) return err;
+
+    err = execute_sql(db, SQL_CREATE_PDF_PAGES_FTS);
+    if (err != BN_SUCCESS) return err;
+
+    return execute_sql(db, SQL_CREATE_PDF_PAGES_FTS_TRIGGERS);
+}
+
+static BnError migrate_v8(sqlite3 *db) {
+    // Pages indexed before this have no fingerprint and get re-extracted once
+    return execute_sql(db, SQL_CREATE_PDF_FINGERPRINTS_TABLE);
+}
+
+typedef struct {
+    int version;
+    const char *description;
+    BnError (*apply)(sqlite3 *db);
+} SchemaMigration;
+
+// Append new steps here and bump SCHEMA_VERSION; create_schema must
+// produce the same result as running every step
+static const SchemaMigration MIGRATIONS[] = {
+    { 2, "note titles",          migrate_v2 },
+    { 3, "book covers",          migrate_v3 },
+    { 4, "listing indexes",      migrate_v4 },
+    { 5, "book metadata search", migrate_v5 },
+    { 6, "note title search",    migrate_v6 },
+    { 7, "PDF page text",        migrate_v7 },
+    { 8, "PDF fingerprints",     migrate_v8 },
+};
+
+#define MIGRATION_COUNT ((int)(sizeof(MIGRATIONS) / sizeof(MIGRATIONS[0])))
+
+/* Current schema in one go, for new databases */
+static BnError create_schema(sqlite3 *db) {
+    const char *steps[] = {
+        SQL_CREATE_BOOKS_TABLE,
+        SQL_CREATE_NOTES_TABLE,
+        SQL_CREATE_METADATA_TABLE,
+        SQL_CREATE_NOTES_FTS,
+        SQL_CREATE_FTS_TRIGGERS,
+        SQL_CREATE_BOOKS_FTS,
+        SQL_CREATE_BOOKS_FTS_TRIGGERS,
+        SQL_CREATE_INDEXES,
+        SQL_CREATE_PDF_PAGES_TABLE,
+        SQL_CREATE_PDF_PAGES_FTS,
+        SQL_CREATE_PDF_PAGES_FTS_TRIGGERS,
+        SQL_CREATE_PDF_FINGERPRINTS_TABLE,
+    };
+
+    for (size_t i = 0; i < sizeof(steps) / sizeof(steps[0]); i++) {
+        BnError err = execute_sql(db, steps[i]);
+        if (err != BN_SUCCESS) return err;
+    }
+    return BN_SUCCESS;
+}
+
+static BnError read_user_version(sqlite3 *db, int *out_version) {
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db, "PRAGMA user_version;", -1, &stmt, NULL) != SQLITE_OK) {
+        return BN_ERROR_DATABASE;
+    }
+
+    int rc = sqlite3_step(stmt);
+    if (rc == SQLITE_ROW) {
+        *out_version = sqlite3_column_int(stmt, 0);
+    }
+    sqlite3_finalize(stmt);
+
+    return rc == SQLITE_ROW ? BN_SUCCESS : BN_ERROR_DATABASE;
+}
+
+/* Record the version in the file header and, for older binaries, in metadata */
+static BnError write_version(sqlite3 *db, int version) {
+    char sql[160];
+    snprintf(sql, sizeof(sql),
+             "PRAGMA user_version = %d;"
+             "INSERT OR REPLACE INTO metadata (key, value) VALUES ('schema_version', '%d');",
+             version, version);
+    return execute_sql(db, sql);
+}
+
+/*
+ * Version of a database that predates user_version: 0 if it is empty,
+ * else the metadata row (version 1 databases had none)
+ */
+static BnError detect_legacy_version(sqlite3 *db, int *out_version) {
+    int exists = 0;
+    BnError err = schema_has_table(db, "books", &exists);
+    if (err != BN_SUCCESS) return err;
+
+    if (!exists) {
+        *out_version = 0;
+        return BN_SUCCESS;
+    }
+
+    err = schema_has_table(db, "metadata", &exists);
+    if (err != BN_SUCCESS) return err;
+
+    *out_version = 1;
+    if (!exists) {
+        return execute_sql(db, SQL_CREATE_METADATA_TABLE);
+    }
+
+    sqlite3_stmt *stmt;
+    const char *sql = "SELECT value FROM metadata WHERE key = 'schema_version';";
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) != SQLITE_OK) {
+        return BN_ERROR_DATABASE;
+    }
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        *out_version = sqlite3_column_int(stmt, 0);
+    }
+    sqlite3_finalize(stmt);
+
+    return BN_SUCCESS;
+}
+
+static double elapsed_ms(const struct timespec *start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) * 1e3 + (now.tv_nsec - start->tv_nsec) / 1e6;
+}
+
+/*
+ * Run one step in its own write transaction. The version is re-read
+ * under the lock, so a second process opening the same old database
+ * waits and then skips the work.
+ */
+static BnError run_step(sqlite3 *db, int version, const char *description,
+                        BnError (*apply)(sqlite3 *db), int *io_version) {
+    BnError err = execute_sql(db, "BEGIN IMMEDIATE;");
+    if (err != BN_SUCCESS) return err;
+
+    int current = 0;
+    err = read_user_version(db, &current);
+    if (err == BN_SUCCESS && current >= version) {
+        *io_version = current;
+        return execute_sql(db, "COMMIT;");
+    }
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    if (err == BN_SUCCESS) {
+        err = apply(db);
+    }
+    if (err == BN_SUCCESS) {
+        err = write_version(db, version);
+    }
+    if (err == BN_SUCCESS) {
+        err = execute_sql(db, "COMMIT;");
+    }
+    if (err != BN_SUCCESS) {
+        execute_sql(db, "ROLLBACK;");
+        fprintf(stderr, "Migration to version %d (%s) failed; database left at version %d\n",
+                version, description, current);
+        return err;
+    }
+
+    // stderr: stdout carries the output of the command that triggered the upgrade
+    fprintf(stderr, "Migrated database to version %d (%s) in %.1f ms\n", version, description, elapsed_ms(&start));
+    *io_version = version;
+    return BN_SUCCESS;
+}
+
+/*
+ * First open of a file without user_version: create the current schema
+ * if it is empty, else stamp the version found in metadata so the
+ * remaining steps can run
+ */
+static BnError create_or_adopt(sqlite3 *db, int *io_version) {
+    BnError err = execute_sql(db, "BEGIN IMMEDIATE;");
     if (err != BN_SUCCESS) return err;
 
-    // Check if migration is needed for existing databases
     int version = 0;
-    BnError ver_err = schema_get_version(db, &version);
-    
-    if (ver_err == BN_SUCCESS && version < 2) {
-        printf("Old database detected (v%d). Migrating...\n", version);
-        err = migrate_to_v2(db);
-        if (err != BN_SUCCESS) {
-            return err;
+    err = read_user_version(db, &version);
+    if (err == BN_SUCCESS && version == 0) {
+        err = detect_legacy_version(db, &version);
+        if (err == BN_SUCCESS && version == 0) {
+            err = create_schema(db);
+            version = SCHEMA_VERSION;
+        }
+        if (err == BN_SUCCESS) {
+            err = write_version(db, version);
         }
-        version = 2;
     }
-    if (ver_err == BN_SUCCESS && version < 3) {
-        printf("Migrating database to version 3...\n");
-        // Add cover_path column to books table (backward-compatible)
-        const char *sql = "ALTER TABLE books ADD COLUMN cover_path TEXT;";
-        err = execute_sql(db, sql);
+    if (err == BN_SUCCESS) {
+        err = execute_sql(db, "COMMIT;");
+    }
+    if (err != BN_SUCCESS) {
+        execute_sql(db, "ROLLBACK;");
+        return err;
+    }
+
+    *io_version = version;
+    return BN_SUCCESS;
+}
+
+BnError schema_initialize(sqlite3 *db) {
+    if (!db) {
+        return BN_ERROR_INVALID_ARG;
+    }
+
+    // Fast path: an up-to-date database costs one pragma read
+    int version = 0;
+    BnError err = read_user_version(db, &version);
+    if (err != BN_SUCCESS || version == SCHEMA_VERSION) {
+        return err;
+    }
+
+    if (version > SCHEMA_VERSION) {
+        fprintf(stderr, "Database schema version %d is newer than this booknote (%d)\n",
+                version, SCHEMA_VERSION);
+        return BN_ERROR_DATABASE;
+    }
+
+    if (version == 0) {
+        err = create_or_adopt(db, &version);
         if (err != BN_SUCCESS) {
             return err;
         }
-        // Update schema version
-        const char *update_version = "UPDATE metadata SET value = '3' WHERE key = 'schema_version';";
-        err = execute_sql(db, update_version);
+    }
+
+    for (int i = 0; i < MIGRATION_COUNT; i++) {
+        if (MIGRATIONS[i].version <= version) {
+            continue;
+        }
+        err = run_step(db, MIGRATIONS[i].version, MIGRATIONS[i].description, MIGRATIONS[i].apply, &version);
         if (err != BN_SUCCESS) {
             return err;
         }
-        printf("Migration to v3 complete\n");
     }
 
     return BN_SUCCESS;
@@ -156,26 +527,10 @@ BnError schema_get_version(sqlite3 *db, int *out_version) {
         return BN_ERROR_INVALID_ARG;
     }
 
-    const char *sql = "SELECT value FROM metadata WHERE key = 'schema_version';";
-    sqlite3_stmt *stmt;
-
-    int rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
-    if (rc != SQLITE_OK) {
-        return BN_ERROR_DATABASE;
+    BnError err = read_user_version(db, out_version);
+    if (err != BN_SUCCESS) {
+        return err;
     }
 
-    rc = sqlite3_step(stmt);
-    if (rc == SQLITE_ROW) {
-        const char *version_str = (const char *)sqlite3_column_text(stmt, 0);
-        *out_version = atoi(version_str);
-        sqlite3_finalize(stmt);
-        return BN_SUCCESS;
-    } else if (rc == SQLITE_DONE) {
-        sqlite3_finalize(stmt);
-        *out_version = 0;
-        return BN_ERROR_NOT_FOUND;
-    } else {
-        sqlite3_finalize(stmt);
-        return BN_ERROR_DATABASE;
-    }
+    return *out_version > 0 ? BN_SUCCESS : BN_ERROR_NOT_FOUND;
 }
@@ -7,7 +7,7 @@
 /**
  * Current database schema version
  */
-#define SCHEMA_VERSION 1
+#define SCHEMA_VERSION 8
 
 /**
  * SQL statement to create books table
@@ -29,6 +29,57 @@ extern const char *SQL_CREATE_NOTES_FTS;
  */
 extern const char *SQL_CREATE_FTS_TRIGGERS;
 
+/**
+ * SQL statement to create FTS index for book metadata
+ */
+extern const char *SQL_CREATE_BOOKS_FTS;
+
+/**
+ * SQL statement to create book FTS triggers
+ */
+extern const char *SQL_CREATE_BOOKS_FTS_TRIGGERS;
+
+/**
+ * SQL statement to create the trigram FTS index for substring search
+ * Optional: see schema_set_trigram_index
+ */
+extern const char *SQL_CREATE_NOTES_TRIGRAM;
+
+/**
+ * SQL statement to create trigram FTS triggers
+ */
+extern const char *SQL_CREATE_TRIGRAM_TRIGGERS;
+
+/**
+ * SQL statement to create the table of text extracted from book PDFs
+ * One row per non-empty page, removed with its book
+ */
+extern const char *SQL_CREATE_PDF_PAGES_TABLE;
+
+/**
+ * SQL statement to create the FTS index over PDF page text
+ */
+extern const char *SQL_CREATE_PDF_PAGES_FTS;
+
+/**
+ * SQL statement to create PDF page FTS triggers
+ */
+extern const char *SQL_CREATE_PDF_PAGES_FTS_TRIGGERS;
+
+/**
+ * SQL statement to create the table of PDF fingerprints
+ * Size, mtime and content hash of each book's file when it was last
+ * indexed, so unchanged files are not extracted again
+ */
+extern const char *SQL_CREATE_PDF_FINGERPRINTS_TABLE;
+
+/**
+ * SQL statement to create secondary indexes
+ * notes(book_id, created_at) serves the per-book note listing and
+ * books(title COLLATE NOCASE) the title-sorted library view.
+ */
+extern const char *SQL_CREATE_INDEXES;
+
 /**
  * SQL statement to create metadata table
  */
@@ -36,7 +87,9 @@ extern const char *SQL_CREATE_METADATA_TABLE;
 
 /**
  * Initialize database schema
- * Creates all tables if they don't exist
+ * Reads PRAGMA user_version and returns at once when it is current. A new
+ * file gets the whole schema in one transaction; an older one runs each
+ * pending migration in its own transaction and prints how long it took.
  * 
  * @param db SQLite database handle
  * @return BN_SUCCESS on success, error code otherwise
@@ -44,12 +97,33 @@ extern const char *SQL_CREATE_METADATA_TABLE;
 BnError schema_initialize(sqlite3 *db);
 
 /**
- * Get current schema version from database
+ * Get current schema version from database (PRAGMA user_version)
  * 
  * @param db SQLite database handle
  * @param out_version Pointer to store version number
- * @return BN_SUCCESS on success, error code otherwise
+ * @return BN_SUCCESS on success, BN_ERROR_NOT_FOUND if never initialized
  */
 BnError schema_get_version(sqlite3 *db, int *out_version);
 
+/**
+ * Check whether a table exists
+ * 
+ * @param db SQLite database handle
+ * @param name Table name
+ * @param out_exists Pointer to store 1 if the table exists, 0 otherwise
+ * @return BN_SUCCESS on success, error code otherwise
+ */
+BnError schema_has_table(sqlite3 *db, const char *name, int *out_exists);
+
+/**
+ * Create (and populate) or drop the optional trigram index
+ * The index needs the FTS5 trigram tokenizer (SQLite 3.34+) and costs
+ * several times the size of the word index, so it is opt-in.
+ * 
+ * @param db SQLite database handle
+ * @param enabled Non-zero to create the index, zero to drop it
+ * @return BN_SUCCESS on success (including when nothing changes)
+ */
+BnError schema_set_trigram_index(sqlite3 *db, int enabled);
+
 #endif // BOOKNOTE_SCHEMA_H
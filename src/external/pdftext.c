@@ -0,0 +1,326 @@
+/*
+ * booknote/src/external/pdftext.c
+ *
+ * Parallel PDF text extraction into the pdf_pages table.
+ *
+ * Build dependencies (via pkg-config, optional):
+ * - poppler-glib, enabled by defining HAVE_POPPLER
+ *
+ * Notes:
+ * - Each extraction thread owns a PopplerDocument; pages are handed out
+ *   one at a time from a shared counter, so threads that hit cheap pages
+ *   simply take more of them.
+ * - Only the calling thread touches the database.
+ * - The fingerprint is taken before extraction, so a file modified while
+ *   it is being read is picked up again by the next run.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#include "pdftext.h"
+#include "../database/queries.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#ifdef HAVE_POPPLER
+#include <poppler.h>
+#include <pthread.h>
+#endif
+
+/* -------------------------------------------------------------------------
+ * Internal helpers
+ * ------------------------------------------------------------------------- */
+
+#define FINGERPRINT_BLOCK (64 * 1024)
+#define FNV_OFFSET 0xcbf29ce484222325ULL
+#define FNV_PRIME 0x100000001b3ULL
+
+static unsigned long long fnv1a(unsigned long long hash, const unsigned char *data, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        hash ^= data[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+/* Hash one block of the file at offset into hash */
+static int hash_block(FILE *f, long long offset, unsigned char *buf, unsigned long long *hash) {
+    if (fseeko(f, (off_t)offset, SEEK_SET) != 0) {
+        return -1;
+    }
+    size_t n = fread(buf, 1, FINGERPRINT_BLOCK, f);
+    if (ferror(f)) {
+        return -1;
+    }
+    *hash = fnv1a(*hash, buf, n);
+    return 0;
+}
+
+/*
+ * Decide whether book_id's file must be extracted again. current receives
+ * the file's fingerprint; an unchanged file whose mtime moved gets its
+ * stored fingerprint refreshed so the next run takes the fast path.
+ */
+static BnError check_unchanged(Database *db, int book_id, const char *path,
+                               PdfFingerprint *current, int *out_unchanged) {
+    *out_unchanged = 0;
+
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        return BN_ERROR_FILE_NOT_FOUND;
+    }
+
+    PdfFingerprint stored;
+    BnError err = db_pdf_fingerprint_get(db, book_id, &stored);
+    if (err != BN_SUCCESS && err != BN_ERROR_NOT_FOUND) {
+        return err;
+    }
+    int known = err == BN_SUCCESS;
+
+    /* Fast path: nothing is read */
+    long long mtime_ns = (long long)st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+    if (known && stored.file_size == (long long)st.st_size && stored.mtime_ns == mtime_ns) {
+        *current = stored;
+        *out_unchanged = 1;
+        return BN_SUCCESS;
+    }
+
+    err = pdftext_fingerprint(path, current);
+    if (err != BN_SUCCESS) {
+        return err;
+    }
+
+    if (known && stored.file_size == current->file_size && stored.hash == current->hash) {
+        *out_unchanged = 1;
+        return db_pdf_fingerprint_set(db, book_id, current);
+    }
+    return BN_SUCCESS;
+}
+
+#ifdef HAVE_POPPLER
+
+static double seconds_between(const struct timespec *start, const struct timespec *end) {
+    return (end->tv_sec - start->tv_sec) + (end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+typedef struct {
+    const char *uri;
+    int page_count;
+    char **texts;               /* One slot per page, filled by the threads */
+
+    pthread_mutex_t lock;
+    int next_page;              /* Next page to hand out */
+    int failed;                 /* A thread could not open the document */
+} ExtractJob;
+
+static int claim_page(ExtractJob *job) {
+    pthread_mutex_lock(&job->lock);
+    int page = job->failed ? job->page_count : job->next_page++;
+    pthread_mutex_unlock(&job->lock);
+    return page;
+}
+
+static void *extract_thread(void *data) {
+    ExtractJob *job = (ExtractJob *)data;
+
+    PopplerDocument *doc = poppler_document_new_from_file(job->uri, NULL, NULL);
+    if (!doc) {
+        pthread_mutex_lock(&job->lock);
+        job->failed = 1;
+        pthread_mutex_unlock(&job->lock);
+        return NULL;
+    }
+
+    int index;
+    while ((index = claim_page(job)) < job->page_count) {
+        PopplerPage *page = poppler_document_get_page(doc, index);
+        if (page) {
+            job->texts[index] = poppler_page_get_text(page);
+            g_object_unref(page);
+        }
+    }
+
+    g_object_unref(doc);
+    return NULL;
+}
+
+#endif /* HAVE_POPPLER */
+
+/* -------------------------------------------------------------------------
+ * Public API
+ * ------------------------------------------------------------------------- */
+
+int pdftext_available(void) {
+#ifdef HAVE_POPPLER
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+BnError pdftext_fingerprint(const char *path, PdfFingerprint *out_fingerprint) {
+    if (!path || !out_fingerprint) {
+        return BN_ERROR_INVALID_ARG;
+    }
+
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        return BN_ERROR_FILE_NOT_FOUND;
+    }
+
+    struct stat st;
+    unsigned char *buf = malloc(FINGERPRINT_BLOCK);
+    if (!buf || fstat(fileno(f), &st) != 0) {
+        free(buf);
+        fclose(f);
+        return buf ? BN_ERROR_FILE_NOT_FOUND : BN_ERROR_OUT_OF_MEMORY;
+    }
+
+    /* The size is mixed in, so appending to a file always changes the hash */
+    long long size = (long long)st.st_size;
+    unsigned long long hash = fnv1a(FNV_OFFSET, (const unsigned char *)&size, sizeof(size));
+    int rc = hash_block(f, 0, buf, &hash);
+    if (rc == 0 && size > FINGERPRINT_BLOCK) {
+        long long tail = size - FINGERPRINT_BLOCK > FINGERPRINT_BLOCK ? size - FINGERPRINT_BLOCK : FINGERPRINT_BLOCK;
+        rc = hash_block(f, tail, buf, &hash);
+    }
+
+    free(buf);
+    fclose(f);
+    if (rc != 0) {
+        return BN_ERROR_FILE_NOT_FOUND;
+    }
+
+    out_fingerprint->file_size = size;
+    out_fingerprint->mtime_ns = (long long)st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+    out_fingerprint->hash = (long long)hash;
+    return BN_SUCCESS;
+}
+
+int pdftext_default_threads(void) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return cpus > 0 ? (int)cpus : 1;
+}
+
+BnError pdftext_index_book(Database *db, int book_id, const char *pdf_path, int threads,
+                           int flags, PdfIndexStats *out_stats) {
+    if (!db || book_id <= 0 || !pdf_path) {
+        return BN_ERROR_INVALID_ARG;
+    }
+
+#ifndef HAVE_POPPLER
+    (void)threads;
+    (void)flags;
+    (void)out_stats;
+    (void)check_unchanged;
+    return BN_ERROR_UNKNOWN;
+#else
+    struct timespec start, extracted, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    PdfFingerprint fingerprint;
+    int unchanged = 0;
+    BnError err = check_unchanged(db, book_id, pdf_path, &fingerprint, &unchanged);
+    if (err != BN_SUCCESS) {
+        return err;
+    }
+    if (unchanged && !(flags & PDFTEXT_FORCE)) {
+        if (out_stats) {
+            memset(out_stats, 0, sizeof(*out_stats));
+            out_stats->unchanged = 1;
+        }
+        return BN_SUCCESS;
+    }
+
+    /* Relative paths (as stored by `booknote add book.pdf`) are taken from
+     * the working directory, as the viewer does */
+    char *absolute = g_canonicalize_filename(pdf_path, NULL);
+    char *uri = g_filename_to_uri(absolute, NULL, NULL);
+    g_free(absolute);
+    if (!uri) {
+        return BN_ERROR_FILE_NOT_FOUND;
+    }
+
+    /* Only for the page count; the threads open their own */
+    PopplerDocument *doc = poppler_document_new_from_file(uri, NULL, NULL);
+    if (!doc) {
+        g_free(uri);
+        return BN_ERROR_FILE_NOT_FOUND;
+    }
+    int page_count = poppler_document_get_n_pages(doc);
+    g_object_unref(doc);
+
+    if (threads <= 0) {
+        threads = pdftext_default_threads();
+    }
+    if (threads > page_count) {
+        threads = page_count > 0 ? page_count : 1;
+    }
+
+    ExtractJob job;
+    memset(&job, 0, sizeof(job));
+    job.uri = uri;
+    job.page_count = page_count;
+    job.texts = calloc(page_count > 0 ? page_count : 1, sizeof(char *));
+    pthread_t *workers = calloc(threads, sizeof(pthread_t));
+    if (!job.texts || !workers) {
+        free(job.texts);
+        free(workers);
+        g_free(uri);
+        return BN_ERROR_OUT_OF_MEMORY;
+    }
+    pthread_mutex_init(&job.lock, NULL);
+
+    int started = 0;
+    for (int i = 0; i < threads; i++) {
+        if (pthread_create(&workers[i], NULL, extract_thread, &job) != 0) {
+            break;
+        }
+        started++;
+    }
+    /* Fewer threads only means a slower run; none at all means no work */
+    if (started == 0) {
+        extract_thread(&job);
+    }
+    for (int i = 0; i < started; i++) {
+        pthread_join(workers[i], NULL);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &extracted);
+
+    err = job.failed ? BN_ERROR_FILE_NOT_FOUND : BN_SUCCESS;
+    int stored = 0;
+    if (err == BN_SUCCESS) {
+        err = db_pdf_pages_replace(db, book_id, (const char *const *)job.texts, page_count,
+                                   &fingerprint, &stored);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    long long chars = 0;
+    for (int i = 0; i < page_count; i++) {
+        if (job.texts[i]) {
+            chars += (long long)strlen(job.texts[i]);
+            g_free(job.texts[i]);
+        }
+    }
+
+    pthread_mutex_destroy(&job.lock);
+    free(job.texts);
+    free(workers);
+    g_free(uri);
+
+    if (err == BN_SUCCESS && out_stats) {
+        out_stats->unchanged = 0;
+        out_stats->pages = page_count;
+        out_stats->stored_pages = stored;
+        out_stats->chars = chars;
+        out_stats->threads = started > 0 ? started : 1;
+        out_stats->extract_seconds = seconds_between(&start, &extracted);
+        out_stats->total_seconds = seconds_between(&start, &end);
+    }
+    return err;
+#endif
+}
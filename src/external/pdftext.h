@@ -0,0 +1,94 @@
+#ifndef BOOKNOTE_EXTERNAL_PDFTEXT_H
+#define BOOKNOTE_EXTERNAL_PDFTEXT_H
+
+/*
+ * booknote/src/external/pdftext.h
+ *
+ * PDF text extraction into the pdf_pages table.
+ *
+ * Pages are extracted in parallel by a small pool of threads. Poppler
+ * documents are not safe to share between threads, so every thread opens
+ * its own PopplerDocument and claims the next unextracted page until none
+ * are left. The calling thread then stores all pages in one transaction.
+ *
+ * Re-indexing is incremental: a file whose size and mtime match its stored
+ * fingerprint is skipped without being read. If only the mtime changed,
+ * a hash of the first and last blocks decides whether it really changed.
+ *
+ * Dependencies (linked via pkg-config when available):
+ * - poppler-glib (the CLI builds without it; extraction then reports
+ *   BN_ERROR_UNKNOWN and pdftext_available() returns 0)
+ */
+
+#include "../database/queries.h"
+
+/* Flags for pdftext_index_book */
+#define PDFTEXT_FORCE 1     /* Extract even if the file is unchanged */
+
+/*
+ * PdfIndexStats
+ *
+ * Result of indexing one PDF.
+ */
+typedef struct {
+    int unchanged;          /* 1 if skipped because the file is unchanged */
+    int pages;              /* Pages in the document */
+    int stored_pages;       /* Pages with text (blank pages are not stored) */
+    long long chars;        /* Bytes of text extracted */
+    int threads;            /* Extraction threads used */
+    double extract_seconds; /* Wall time spent extracting */
+    double total_seconds;   /* Wall time including the database writes */
+} PdfIndexStats;
+
+/*
+ * pdftext_available
+ *
+ * Returns 1 if this build can extract PDF text, 0 otherwise.
+ */
+int pdftext_available(void);
+
+/*
+ * pdftext_default_threads
+ *
+ * Number of extraction threads to use when the caller has no preference:
+ * one per online CPU.
+ */
+int pdftext_default_threads(void);
+
+/*
+ * pdftext_fingerprint
+ *
+ * Compute the fingerprint of a file: size, mtime (ns) and a 64-bit FNV-1a
+ * hash of its first and last 64 KiB. Reads at most 128 KiB.
+ *
+ * Returns:
+ * - BN_SUCCESS on success
+ * - BN_ERROR_FILE_NOT_FOUND if the file cannot be read
+ */
+BnError pdftext_fingerprint(const char *path, PdfFingerprint *out_fingerprint);
+
+/*
+ * pdftext_index_book
+ *
+ * Extract the text of every page of pdf_path and replace the pages stored
+ * for book_id with it, unless the file is unchanged since it was last
+ * indexed (out_stats->unchanged is then set and nothing is extracted).
+ *
+ * Parameters:
+ * - db:        Database connection (writer); only used by the calling thread
+ * - book_id:   Book the PDF belongs to
+ * - pdf_path:  Path to the PDF file
+ * - threads:   Extraction threads (<= 0 for pdftext_default_threads())
+ * - flags:     0 or PDFTEXT_FORCE
+ * - out_stats: Optional pointer to receive page counts and timings
+ *
+ * Returns:
+ * - BN_SUCCESS on success
+ * - BN_ERROR_FILE_NOT_FOUND if the PDF cannot be opened
+ * - BN_ERROR_UNKNOWN if built without poppler
+ * - Other error codes from the database layer
+ */
+BnError pdftext_index_book(Database *db, int book_id, const char *pdf_path, int threads,
+                           int flags, PdfIndexStats *out_stats);
+
+#endif /* BOOKNOTE_EXTERNAL_PDFTEXT_H */
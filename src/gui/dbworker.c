@@ -0,0 +1,204 @@
+#include "dbworker.h"
+#include "../database/pool.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+// A thread and its queue; jobs run on one pool connection in order
+typedef struct {
+    DbWorker *worker;
+    GThread *thread;
+    GAsyncQueue *jobs;
+    int writer;                 // Holds the pool's writer, else a reader
+} DbWorkerLane;
+
+struct DbWorker {
+    gint ref_count;             // Owner + one per job in flight
+    DbPool *pool;               // NULL if the file could not be opened
+    DbWorkerLane write_lane;
+    DbWorkerLane read_lane;
+    Database *main_db;          // NULL once destroyed (main thread only)
+};
+
+typedef struct {
+    DbWorker *worker;
+    DbWorkerFunc run;
+    void *task;
+    GDestroyNotify free_task;
+    DbWorkerDone done;
+    GDestroyNotify free_result;
+    gpointer user_data;
+
+    // Filled in on the worker thread
+    BnError err;
+    void *result;
+    GArray *changes;            // DbChange committed by this job
+} DbWorkerJob;
+
+// Queued by dbworker_destroy to stop the threads
+static DbWorkerJob stop_job;
+
+static void worker_unref(DbWorker *worker) {
+    if (g_atomic_int_dec_and_test(&worker->ref_count)) {
+        g_async_queue_unref(worker->write_lane.jobs);
+        g_async_queue_unref(worker->read_lane.jobs);
+        free(worker);
+    }
+}
+
+static void collect_change(const DbChange *change, void *user_data) {
+    GArray **changes = (GArray **)user_data;
+    if (*changes) {
+        g_array_append_val(*changes, *change);
+    }
+}
+
+static gboolean job_complete(gpointer data) {
+    DbWorkerJob *job = (DbWorkerJob *)data;
+    DbWorker *worker = job->worker;
+
+    if (worker->main_db) {
+        // Views update from the change feed before the caller hears back
+        db_change_forward(worker->main_db, (const DbChange *)job->changes->data, (int)job->changes->len);
+        if (job->done) {
+            job->done(job->err, job->result, job->task, job->user_data);
+            job->result = NULL;
+        }
+    }
+
+    // Nobody took the result
+    if (job->result && job->free_result) {
+        job->free_result(job->result);
+    }
+
+    if (job->free_task) {
+        job->free_task(job->task);
+    }
+    g_array_free(job->changes, TRUE);
+    g_free(job);
+    worker_unref(worker);
+    return G_SOURCE_REMOVE;
+}
+
+static gpointer lane_thread(gpointer data) {
+    DbWorkerLane *lane = (DbWorkerLane *)data;
+    DbPool *pool = lane->worker->pool;
+
+    // The connection stays checked out to this thread until it stops
+    Database *db = NULL;
+    GArray *changes = NULL;
+    if (pool) {
+        BnError err = lane->writer ? db_pool_acquire_writer(pool, &db)
+                                   : db_pool_acquire_reader(pool, &db);
+        if (err != BN_SUCCESS) {
+            db = NULL;
+        }
+    }
+    // Only the writer commits anything for the change feed
+    if (db && lane->writer) {
+        db_change_subscribe(db, collect_change, &changes);
+    }
+
+    for (;;) {
+        DbWorkerJob *job = (DbWorkerJob *)g_async_queue_pop(lane->jobs);
+        if (job == &stop_job) {
+            break;
+        }
+
+        changes = job->changes;
+        job->err = db ? job->run(db, job->task, &job->result) : BN_ERROR_DATABASE;
+        changes = NULL;
+
+        g_idle_add(job_complete, job);
+    }
+
+    if (db) {
+        if (lane->writer) {
+            db_change_unsubscribe(db, collect_change, &changes);
+        }
+        db_pool_release(pool, db);
+    }
+    return NULL;
+}
+
+static void lane_start(DbWorker *worker, DbWorkerLane *lane, int writer, const char *name) {
+    lane->worker = worker;
+    lane->writer = writer;
+    lane->jobs = g_async_queue_new();
+    lane->thread = g_thread_new(name, lane_thread, lane);
+}
+
+DbWorker* dbworker_create(Database *db) {
+    if (!db || !db->path) return NULL;
+
+    DbWorker *worker = calloc(1, sizeof(DbWorker));
+    if (!worker) return NULL;
+
+    // Jobs then fail with BN_ERROR_DATABASE, as they would on a lost connection
+    if (db_pool_open(&worker->pool, db->path, 1) != BN_SUCCESS) {
+        fprintf(stderr, "Database worker: cannot open %s\n", db->path);
+        worker->pool = NULL;
+    }
+
+    worker->ref_count = 1;
+    worker->main_db = db;
+    lane_start(worker, &worker->write_lane, 1, "booknote-db");
+    lane_start(worker, &worker->read_lane, 0, "booknote-db-read");
+
+    return worker;
+}
+
+static BnError submit(DbWorker *worker, DbWorkerLane *lane, DbWorkerFunc run,
+                      void *task, GDestroyNotify free_task,
+                      DbWorkerDone done, GDestroyNotify free_result,
+                      gpointer user_data) {
+    if (!worker || !worker->main_db || !run) {
+        if (free_task) {
+            free_task(task);
+        }
+        return BN_ERROR_INVALID_ARG;
+    }
+
+    DbWorkerJob *job = g_new0(DbWorkerJob, 1);
+    job->worker = worker;
+    job->run = run;
+    job->task = task;
+    job->free_task = free_task;
+    job->done = done;
+    job->free_result = free_result;
+    job->user_data = user_data;
+    job->changes = g_array_new(FALSE, FALSE, sizeof(DbChange));
+
+    g_atomic_int_inc(&worker->ref_count);
+    g_async_queue_push(lane->jobs, job);
+    return BN_SUCCESS;
+}
+
+BnError dbworker_submit(DbWorker *worker, DbWorkerFunc run,
+                        void *task, GDestroyNotify free_task,
+                        DbWorkerDone done, GDestroyNotify free_result,
+                        gpointer user_data) {
+    return submit(worker, worker ? &worker->write_lane : NULL, run, task, free_task,
+                  done, free_result, user_data);
+}
+
+BnError dbworker_submit_read(DbWorker *worker, DbWorkerFunc run,
+                             void *task, GDestroyNotify free_task,
+                             DbWorkerDone done, GDestroyNotify free_result,
+                             gpointer user_data) {
+    return submit(worker, worker ? &worker->read_lane : NULL, run, task, free_task,
+                  done, free_result, user_data);
+}
+
+void dbworker_destroy(DbWorker *worker) {
+    if (!worker) return;
+
+    g_async_queue_push(worker->write_lane.jobs, &stop_job);
+    g_async_queue_push(worker->read_lane.jobs, &stop_job);
+    g_thread_join(worker->write_lane.thread);
+    g_thread_join(worker->read_lane.thread);
+    db_pool_close(worker->pool);
+
+    // Pending completions still free their job and result, but no longer call back
+    worker->main_db = NULL;
+    worker_unref(worker);
+}
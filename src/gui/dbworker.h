@@ -0,0 +1,75 @@
+#ifndef BOOKNOTE_DBWORKER_H
+#define BOOKNOTE_DBWORKER_H
+
+#include <gtk/gtk.h>
+#include "../database/db.h"
+
+/**
+ * Background database worker
+ *
+ * Two threads on a connection pool (see pool.h) for the same database
+ * file: one holds the writer, the other a read-only reader, so a long
+ * load or search does not wait behind a save and vice versa. Jobs on each
+ * thread run in submission order; their completion callbacks run on the
+ * GTK main loop. Rows changed by a job are forwarded to the change feed
+ * subscribers of the main connection before its callback runs.
+ */
+typedef struct DbWorker DbWorker;
+
+/**
+ * Job body, runs on the worker thread
+ *
+ * @param db          Worker connection (never use the GUI's Database here)
+ * @param task        Task data passed to dbworker_submit
+ * @param out_result  Result handed to the completion callback
+ */
+typedef BnError (*DbWorkerFunc)(Database *db, void *task, void **out_result);
+
+/**
+ * Completion callback, runs on the main loop
+ * Takes ownership of result; task is freed after it returns. A job that
+ * completes after dbworker_destroy gets no callback; its result goes to
+ * the free_result passed to dbworker_submit instead.
+ */
+typedef void (*DbWorkerDone)(BnError err, void *result, void *task, gpointer user_data);
+
+/**
+ * Start a worker connected to the same file as db
+ */
+DbWorker* dbworker_create(Database *db);
+
+/**
+ * Queue a job on the writer
+ *
+ * @param run        Job body
+ * @param task       Task data (owned by the job)
+ * @param free_task  Frees task after completion, or NULL
+ * @param done       Completion callback, or NULL
+ * @param free_result Frees a result that done does not receive (no
+ *                   callback, or the worker was destroyed), or NULL
+ * @param user_data  Passed to done
+ */
+BnError dbworker_submit(DbWorker *worker, DbWorkerFunc run,
+                        void *task, GDestroyNotify free_task,
+                        DbWorkerDone done, GDestroyNotify free_result,
+                        gpointer user_data);
+
+/**
+ * Queue a job that only reads (the get, count, search and cursor
+ * functions of queries.h), same arguments as dbworker_submit
+ * It runs on the reader alongside writer jobs and sees every write
+ * committed before it starts.
+ */
+BnError dbworker_submit_read(DbWorker *worker, DbWorkerFunc run,
+                             void *task, GDestroyNotify free_task,
+                             DbWorkerDone done, GDestroyNotify free_result,
+                             gpointer user_data);
+
+/**
+ * Finish queued jobs, stop the threads and close the pool
+ * Completions that have not reached the main loop yet are dropped: their
+ * callbacks are not called and their results are freed with free_result.
+ */
+void dbworker_destroy(DbWorker *worker);
+
+#endif // BOOKNOTE_DBWORKER_H
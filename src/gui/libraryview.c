@@ -10,6 +10,9 @@
 
 static void on_edit_selected_clicked(GtkButton *button, gpointer data);
 static void on_delete_selected_clicked(GtkButton *button, gpointer data);
+static gint sort_book_cards(GtkFlowBoxChild *a, GtkFlowBoxChild *b, gpointer data);
+static void on_db_change(const DbChange *change, void *user_data);
+static void set_card_note_count(GtkWidget *card, int note_count);
 
 static void libraryview_show_edit_dialog(GtkWidget *parent,
                                          Database *db,
@@ -160,8 +163,8 @@ static void on_edit_selected_clicked(GtkButton *button, gpointer data) {
     (void)button;
     LibraryView *view = (LibraryView *)data;
     if (!view) return;
-    libraryview_show_edit_dialog(view->container, view->db, view->selected_book_id,
-                                 (void (*)(void *))libraryview_load_books, view);
+    // The change feed updates the edited card
+    libraryview_show_edit_dialog(view->container, view->db, view->selected_book_id, NULL, NULL);
 }
 
 static void on_delete_selected_clicked(GtkButton *button, gpointer data) {
@@ -193,8 +196,8 @@ static void on_delete_selected_clicked(GtkButton *button, gpointer data) {
         return;
     }
 
+    // The change feed removes the card
     view->selected_book_id = -1;
-    libraryview_load_books(view);
 }
 
 static void on_book_card_clicked(GtkButton *button, gpointer data) {
@@ -441,11 +444,12 @@ void libraryview_show_add_dialog(GtkWidget *parent,
     gtk_widget_destroy(dialog);
 }
 
-LibraryView* libraryview_create(Database *db) {
+LibraryView* libraryview_create(Database *db, DbWorker *worker) {
     LibraryView *view = calloc(1, sizeof(LibraryView));
     if (!view) return NULL;
     
     view->db = db;
+    view->worker = worker;
     view->on_book_selected = NULL;
     view->user_data = NULL;
     view->selected_book_id = -1;
@@ -505,15 +509,245 @@ LibraryView* libraryview_create(Database *db) {
     gtk_widget_set_margin_start(view->grid, 20);
     gtk_widget_set_margin_end(view->grid, 20);
     gtk_widget_set_margin_bottom(view->grid, 20);
+    gtk_flow_box_set_sort_func(GTK_FLOW_BOX(view->grid), sort_book_cards, NULL, NULL);
     
     gtk_container_add(GTK_CONTAINER(view->scrolled), view->grid);
     gtk_box_pack_start(GTK_BOX(view->container), view->scrolled, TRUE, TRUE, 0);
     
+    // Keep the grid in sync with the database
+    db_change_subscribe(view->db, on_db_change, view);
+    
     return view;
 }
 
-void libraryview_load_books(LibraryView *view) {
-    if (!view) return;
+static void show_empty_state(LibraryView *view) {
+    GtkWidget *empty_box = gtk_box_new(GTK_ORIENTATION_VERTICAL, 10);
+    gtk_widget_set_valign(empty_box, GTK_ALIGN_CENTER);
+    gtk_widget_set_halign(empty_box, GTK_ALIGN_CENTER);
+    g_object_set_data(G_OBJECT(empty_box), "empty_state", GINT_TO_POINTER(1));
+    
+    GtkWidget *empty_label = gtk_label_new(NULL);
+    gtk_label_set_markup(GTK_LABEL(empty_label), 
+        "<span size='large'>No books yet</span>\n"
+        "<span size='small'>Click '+ Add Book' to get started</span>");
+    gtk_label_set_justify(GTK_LABEL(empty_label), GTK_JUSTIFY_CENTER);
+    
+    gtk_box_pack_start(GTK_BOX(empty_box), empty_label, FALSE, FALSE, 0);
+    gtk_container_add(GTK_CONTAINER(view->grid), empty_box);
+    gtk_widget_show_all(view->grid);
+}
+
+static GtkWidget* create_book_card(LibraryView *view, const Book *book, int note_count) {
+    // Card container
+    GtkWidget *card = gtk_button_new();
+    gtk_widget_set_size_request(card, 200, 300);
+    g_object_set_data(G_OBJECT(card), "book_id", GINT_TO_POINTER(book->id));
+    g_object_set_data_full(G_OBJECT(card), "book_title", g_strdup(book->title), g_free);
+    g_signal_connect(card, "clicked", G_CALLBACK(on_book_card_clicked), view);
+    
+    GtkWidget *card_box = gtk_box_new(GTK_ORIENTATION_VERTICAL, 10);
+    gtk_widget_set_margin_start(card_box, 15);
+    gtk_widget_set_margin_end(card_box, 15);
+    gtk_widget_set_margin_top(card_box, 15);
+    gtk_widget_set_margin_bottom(card_box, 15);
+    
+    // Cover image (try real cover_path, fallback to placeholder)
+    GtkWidget *cover = gtk_image_new();
+    gtk_widget_set_size_request(cover, 170, 220);
+
+    gboolean cover_set = FALSE;
+    if (book->cover_path && g_file_test(book->cover_path, G_FILE_TEST_EXISTS)) {
+        GError *img_err = NULL;
+        GdkPixbuf *pix = gdk_pixbuf_new_from_file_at_scale(book->cover_path, 170, 220, TRUE, &img_err);
+        if (pix) {
+            gtk_image_set_from_pixbuf(GTK_IMAGE(cover), pix);
+            g_object_unref(pix);
+            cover_set = TRUE;
+        }
+        if (img_err) {
+            g_error_free(img_err);
+        }
+    }
+
+    if (!cover_set) {
+        // Placeholder colored box
+        cairo_surface_t *surface = cairo_image_surface_create(CAIRO_FORMAT_RGB24, 170, 220);
+        cairo_t *cr = cairo_create(surface);
+
+        // Random-ish color based on book ID
+        double hue = ((book->id * 137) % 360) / 360.0;
+        double r, g, b;
+        // Simple HSV to RGB (S=0.3, V=0.6 for muted colors)
+        double c = 0.6 * 0.3;
+        double x = c * (1 - fabs(fmod(hue * 6, 2) - 1));
+        double m = 0.6 - c;
+        if (hue < 1.0/6) { r = c; g = x; b = 0; }
+        else if (hue < 2.0/6) { r = x; g = c; b = 0; }
+        else if (hue < 3.0/6) { r = 0; g = c; b = x; }
+        else if (hue < 4.0/6) { r = 0; g = x; b = c; }
+        else if (hue < 5.0/6) { r = x; g = 0; b = c; }
+        else { r = c; g = 0; b = x; }
+
+        cairo_set_source_rgb(cr, r + m, g + m, b + m);
+        cairo_paint(cr);
+
+        // Draw book icon/text
+        cairo_set_source_rgb(cr, 1, 1, 1);
+        cairo_select_font_face(cr, "Sans", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_BOLD);
+        cairo_set_font_size(cr, 14);
+        cairo_move_to(cr, 10, 30);
+        cairo_show_text(cr, "BOOK");
+
+        cairo_destroy(cr);
+
+        unsigned char *src_data = cairo_image_surface_get_data(surface);
+        int src_stride = cairo_image_surface_get_stride(surface);
+        if (src_data && src_stride > 0) {
+            int out_w = 170;
+            int out_h = 220;
+            int dst_stride = out_w * 3; /* RGB */
+            unsigned char *dst_data = g_malloc(out_h * dst_stride);
+            if (dst_data) {
+                for (int y = 0; y < out_h; y++) {
+                    const unsigned char *src_row = src_data + y * src_stride;
+                    unsigned char *dst_row = dst_data + y * dst_stride;
+                    for (int x = 0; x < out_w; x++) {
+                        unsigned char b = src_row[x * 4 + 0];
+                        unsigned char g = src_row[x * 4 + 1];
+                        unsigned char r = src_row[x * 4 + 2];
+                        dst_row[x * 3 + 0] = r;
+                        dst_row[x * 3 + 1] = g;
+                        dst_row[x * 3 + 2] = b;
+                    }
+                }
+                void destroy_notify(guchar *pixels, gpointer data) {
+                    (void)data;
+                    g_free(pixels);
+                }
+                GdkPixbuf *pixbuf = gdk_pixbuf_new_from_data(
+                    dst_data,
+                    GDK_COLORSPACE_RGB,
+                    FALSE,
+                    8,
+                    out_w,
+                    out_h,
+                    dst_stride,
+                    destroy_notify,
+                    NULL
+                );
+                if (pixbuf) {
+                    gtk_image_set_from_pixbuf(GTK_IMAGE(cover), pixbuf);
+                    g_object_unref(pixbuf);
+                } else {
+                    g_free(dst_data);
+                }
+            }
+        }
+        cairo_surface_destroy(surface);
+    }
+
+    gtk_box_pack_start(GTK_BOX(card_box), cover, FALSE, FALSE, 0);
+    
+    // Title (truncated)
+    char title_text[60];
+    snprintf(title_text, sizeof(title_text), "%.55s%s", 
+            book->title, strlen(book->title) > 55 ? "..." : "");
+    GtkWidget *title_label = gtk_label_new(title_text);
+    gtk_label_set_line_wrap(GTK_LABEL(title_label), TRUE);
+    gtk_label_set_max_width_chars(GTK_LABEL(title_label), 20);
+    gtk_label_set_justify(GTK_LABEL(title_label), GTK_JUSTIFY_CENTER);
+    PangoAttrList *attrs = pango_attr_list_new();
+    pango_attr_list_insert(attrs, pango_attr_weight_new(PANGO_WEIGHT_BOLD));
+    gtk_label_set_attributes(GTK_LABEL(title_label), attrs);
+    pango_attr_list_unref(attrs);
+    gtk_box_pack_start(GTK_BOX(card_box), title_label, FALSE, FALSE, 0);
+    
+    // Author
+    if (book->author) {
+        char author_text[40];
+        snprintf(author_text, sizeof(author_text), "%.35s%s",
+                book->author, strlen(book->author) > 35 ? "..." : "");
+        GtkWidget *author_label = gtk_label_new(author_text);
+        gtk_label_set_line_wrap(GTK_LABEL(author_label), TRUE);
+        gtk_label_set_max_width_chars(GTK_LABEL(author_label), 20);
+        gtk_widget_set_opacity(author_label, 0.7);
+        gtk_box_pack_start(GTK_BOX(card_box), author_label, FALSE, FALSE, 0);
+    }
+    
+    // Note count badge
+    GtkWidget *badge = gtk_label_new(NULL);
+    gtk_widget_set_name(badge, "note-count-badge");
+    gtk_widget_set_halign(badge, GTK_ALIGN_CENTER);
+    gtk_box_pack_start(GTK_BOX(card_box), badge, FALSE, FALSE, 0);
+    g_object_set_data(G_OBJECT(card), "badge", badge);
+    set_card_note_count(card, note_count);
+    
+    gtk_container_add(GTK_CONTAINER(card), card_box);
+    return card;
+}
+
+static void set_card_note_count(GtkWidget *card, int note_count) {
+    GtkWidget *badge = g_object_get_data(G_OBJECT(card), "badge");
+    g_object_set_data(G_OBJECT(card), "note_count", GINT_TO_POINTER(note_count));
+    
+    char text[32];
+    snprintf(text, sizeof(text), note_count == 1 ? "1 note" : "%d notes", note_count);
+    gtk_label_set_text(GTK_LABEL(badge), text);
+    gtk_widget_set_opacity(badge, note_count > 0 ? 1.0 : 0.5);
+}
+
+/* Note count of book_id in counts, which is sorted by book id */
+static int lookup_note_count(const BookNoteCount *counts, int count, int book_id) {
+    int lo = 0;
+    int hi = count - 1;
+    while (lo <= hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (counts[mid].book_id == book_id) return counts[mid].note_count;
+        if (counts[mid].book_id < book_id) lo = mid + 1;
+        else hi = mid - 1;
+    }
+    return 0;
+}
+
+/* Result of a library load: the books and, from one query, their note counts */
+typedef struct {
+    BookResultSet *books;
+    BookNoteCount *counts;
+    int count_count;
+} LibraryLoad;
+
+static void library_load_free(LibraryLoad *load) {
+    if (!load) return;
+    db_book_result_free(load->books);
+    free(load->counts);
+    free(load);
+}
+
+/* Worker thread: task is the load generation */
+static BnError load_books_task(Database *db, void *task, void **out_result) {
+    (void)task;
+    LibraryLoad *load = calloc(1, sizeof(LibraryLoad));
+    if (!load) return BN_ERROR_OUT_OF_MEMORY;
+    
+    BnError err = db_book_get_all_arena(db, &load->books);
+    if (err == BN_SUCCESS) {
+        err = db_note_counts_by_book(db, &load->counts, &load->count_count);
+    }
+    *out_result = load;
+    return err;
+}
+
+static void on_books_loaded(BnError err, void *result, void *task, gpointer user_data) {
+    LibraryView *view = (LibraryView *)user_data;
+    LibraryLoad *load = (LibraryLoad *)result;
+    BookResultSet *set = load ? load->books : NULL;
+    
+    // A newer load supersedes this one
+    if (GPOINTER_TO_UINT(task) != view->load_generation) {
+        library_load_free(load);
+        return;
+    }
+    view->load_pending = FALSE;
     
     // Clear existing books
     GList *children = gtk_container_get_children(GTK_CONTAINER(view->grid));
@@ -522,174 +756,149 @@ void libraryview_load_books(LibraryView *view) {
     }
     g_list_free(children);
     
-    // Load books from database
-    Book **books = NULL;
-    int count = 0;
-    
-    BnError err = db_book_get_all(view->db, &books, &count);
-    if (err != BN_SUCCESS || count == 0) {
-        // Show empty state
-        GtkWidget *empty_box = gtk_box_new(GTK_ORIENTATION_VERTICAL, 10);
-        gtk_widget_set_valign(empty_box, GTK_ALIGN_CENTER);
-        gtk_widget_set_halign(empty_box, GTK_ALIGN_CENTER);
-        
-        GtkWidget *empty_label = gtk_label_new(NULL);
-        gtk_label_set_markup(GTK_LABEL(empty_label), 
-            "<span size='large'>No books yet</span>\n"
-            "<span size='small'>Click '+ Add Book' to get started</span>");
-        gtk_label_set_justify(GTK_LABEL(empty_label), GTK_JUSTIFY_CENTER);
-        
-        gtk_box_pack_start(GTK_BOX(empty_box), empty_label, FALSE, FALSE, 0);
-        gtk_container_add(GTK_CONTAINER(view->grid), empty_box);
-        gtk_widget_show_all(view->grid);
+    if (err != BN_SUCCESS || set->count == 0) {
+        library_load_free(load);
+        show_empty_state(view);
         return;
     }
     
     // Create book cards
-    for (int i = 0; i < count; i++) {
-        // Card container
-        GtkWidget *card = gtk_button_new();
-        gtk_widget_set_size_request(card, 200, 300);
-        g_object_set_data(G_OBJECT(card), "book_id", GINT_TO_POINTER(books[i]->id));
-        g_signal_connect(card, "clicked", G_CALLBACK(on_book_card_clicked), view);
-        
-        GtkWidget *card_box = gtk_box_new(GTK_ORIENTATION_VERTICAL, 10);
-        gtk_widget_set_margin_start(card_box, 15);
-        gtk_widget_set_margin_end(card_box, 15);
-        gtk_widget_set_margin_top(card_box, 15);
-        gtk_widget_set_margin_bottom(card_box, 15);
-        
-        // Cover image (try real cover_path, fallback to placeholder)
-        GtkWidget *cover = gtk_image_new();
-        gtk_widget_set_size_request(cover, 170, 220);
-
-        gboolean cover_set = FALSE;
-        if (books[i]->cover_path && g_file_test(books[i]->cover_path, G_FILE_TEST_EXISTS)) {
-            GError *img_err = NULL;
-            GdkPixbuf *pix = gdk_pixbuf_new_from_file_at_scale(books[i]->cover_path, 170, 220, TRUE, &img_err);
-            if (pix) {
-                gtk_image_set_from_pixbuf(GTK_IMAGE(cover), pix);
-                g_object_unref(pix);
-                cover_set = TRUE;
-            }
-            if (img_err) {
-                g_error_free(img_err);
+    for (int i = 0; i < set->count; i++) {
+        int note_count = lookup_note_count(load->counts, load->count_count, set->books[i].id);
+        gtk_container_add(GTK_CONTAINER(view->grid), create_book_card(view, &set->books[i], note_count));
+    }
+    library_load_free(load);
+    
+    gtk_widget_show_all(view->grid);
+}
+
+void libraryview_load_books(LibraryView *view) {
+    if (!view) return;
+    
+    view->load_generation++;
+    view->load_pending = TRUE;
+    dbworker_submit_read(view->worker, load_books_task, GUINT_TO_POINTER(view->load_generation), NULL,
+                         on_books_loaded, (GDestroyNotify)library_load_free, view);
+}
+
+/* Worker thread: recount every book's notes in one query */
+static BnError count_notes_task(Database *db, void *task, void **out_result) {
+    (void)task;
+    LibraryLoad *load = calloc(1, sizeof(LibraryLoad));
+    if (!load) return BN_ERROR_OUT_OF_MEMORY;
+    
+    BnError err = db_note_counts_by_book(db, &load->counts, &load->count_count);
+    *out_result = load;
+    return err;
+}
+
+static void on_notes_counted(BnError err, void *result, void *task, gpointer user_data) {
+    (void)task;
+    LibraryView *view = (LibraryView *)user_data;
+    LibraryLoad *load = (LibraryLoad *)result;
+    view->badge_refresh_pending = FALSE;
+    
+    // A full load in flight brings its own counts
+    if (err == BN_SUCCESS && !view->load_pending) {
+        GList *children = gtk_container_get_children(GTK_CONTAINER(view->grid));
+        for (GList *iter = children; iter != NULL; iter = g_list_next(iter)) {
+            GtkWidget *card = gtk_bin_get_child(GTK_BIN(iter->data));
+            int book_id = card ? GPOINTER_TO_INT(g_object_get_data(G_OBJECT(card), "book_id")) : 0;
+            if (book_id > 0) {
+                set_card_note_count(card, lookup_note_count(load->counts, load->count_count, book_id));
             }
         }
+        g_list_free(children);
+    }
+    
+    library_load_free(load);
+}
 
-        if (!cover_set) {
-            // Placeholder colored box
-            cairo_surface_t *surface = cairo_image_surface_create(CAIRO_FORMAT_RGB24, 170, 220);
-            cairo_t *cr = cairo_create(surface);
-
-            // Random-ish color based on book ID
-            double hue = ((books[i]->id * 137) % 360) / 360.0;
-            double r, g, b;
-            // Simple HSV to RGB (S=0.3, V=0.6 for muted colors)
-            double c = 0.6 * 0.3;
-            double x = c * (1 - fabs(fmod(hue * 6, 2) - 1));
-            double m = 0.6 - c;
-            if (hue < 1.0/6) { r = c; g = x; b = 0; }
-            else if (hue < 2.0/6) { r = x; g = c; b = 0; }
-            else if (hue < 3.0/6) { r = 0; g = c; b = x; }
-            else if (hue < 4.0/6) { r = 0; g = x; b = c; }
-            else if (hue < 5.0/6) { r = x; g = 0; b = c; }
-            else { r = c; g = 0; b = x; }
-
-            cairo_set_source_rgb(cr, r + m, g + m, b + m);
-            cairo_paint(cr);
-
-            // Draw book icon/text
-            cairo_set_source_rgb(cr, 1, 1, 1);
-            cairo_select_font_face(cr, "Sans", CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_BOLD);
-            cairo_set_font_size(cr, 14);
-            cairo_move_to(cr, 10, 30);
-            cairo_show_text(cr, "BOOK");
-
-            cairo_destroy(cr);
-
-            unsigned char *src_data = cairo_image_surface_get_data(surface);
-            int src_stride = cairo_image_surface_get_stride(surface);
-            if (src_data && src_stride > 0) {
-                int out_w = 170;
-                int out_h = 220;
-                int dst_stride = out_w * 3; /* RGB */
-                unsigned char *dst_data = g_malloc(out_h * dst_stride);
-                if (dst_data) {
-                    for (int y = 0; y < out_h; y++) {
-                        const unsigned char *src_row = src_data + y * src_stride;
-                        unsigned char *dst_row = dst_data + y * dst_stride;
-                        for (int x = 0; x < out_w; x++) {
-                            unsigned char b = src_row[x * 4 + 0];
-                            unsigned char g = src_row[x * 4 + 1];
-                            unsigned char r = src_row[x * 4 + 2];
-                            dst_row[x * 3 + 0] = r;
-                            dst_row[x * 3 + 1] = g;
-                            dst_row[x * 3 + 2] = b;
-                        }
-                    }
-                    void destroy_notify(guchar *pixels, gpointer data) {
-                        (void)data;
-                        g_free(pixels);
-                    }
-                    GdkPixbuf *pixbuf = gdk_pixbuf_new_from_data(
-                        dst_data,
-                        GDK_COLORSPACE_RGB,
-                        FALSE,
-                        8,
-                        out_w,
-                        out_h,
-                        dst_stride,
-                        destroy_notify,
-                        NULL
-                    );
-                    if (pixbuf) {
-                        gtk_image_set_from_pixbuf(GTK_IMAGE(cover), pixbuf);
-                        g_object_unref(pixbuf);
-                    } else {
-                        g_free(dst_data);
-                    }
-                }
-            }
-            cairo_surface_destroy(surface);
+/* Coalesce note changes (e.g. a book's notes cascading away) into one recount */
+static void schedule_badge_refresh(LibraryView *view) {
+    if (view->badge_refresh_pending) return;
+    
+    view->badge_refresh_pending =
+        dbworker_submit_read(view->worker, count_notes_task, NULL, NULL, on_notes_counted,
+                            (GDestroyNotify)library_load_free, view) == BN_SUCCESS;
+}
+
+/* FlowBox children wrap either a book card or the empty state box */
+static GtkWidget* find_flowbox_child(LibraryView *view, const char *key, int value) {
+    GtkWidget *found = NULL;
+    GList *children = gtk_container_get_children(GTK_CONTAINER(view->grid));
+    for (GList *iter = children; iter != NULL && !found; iter = g_list_next(iter)) {
+        GtkWidget *inner = gtk_bin_get_child(GTK_BIN(iter->data));
+        if (inner && GPOINTER_TO_INT(g_object_get_data(G_OBJECT(inner), key)) == value) {
+            found = GTK_WIDGET(iter->data);
         }
+    }
+    g_list_free(children);
+    return found;
+}
 
-        gtk_box_pack_start(GTK_BOX(card_box), cover, FALSE, FALSE, 0);
-        
-        // Title (truncated)
-        char title_text[60];
-        snprintf(title_text, sizeof(title_text), "%.55s%s", 
-                books[i]->title, strlen(books[i]->title) > 55 ? "..." : "");
-        GtkWidget *title_label = gtk_label_new(title_text);
-        gtk_label_set_line_wrap(GTK_LABEL(title_label), TRUE);
-        gtk_label_set_max_width_chars(GTK_LABEL(title_label), 20);
-        gtk_label_set_justify(GTK_LABEL(title_label), GTK_JUSTIFY_CENTER);
-        PangoAttrList *attrs = pango_attr_list_new();
-        pango_attr_list_insert(attrs, pango_attr_weight_new(PANGO_WEIGHT_BOLD));
-        gtk_label_set_attributes(GTK_LABEL(title_label), attrs);
-        pango_attr_list_unref(attrs);
-        gtk_box_pack_start(GTK_BOX(card_box), title_label, FALSE, FALSE, 0);
-        
-        // Author
-        if (books[i]->author) {
-            char author_text[40];
-            snprintf(author_text, sizeof(author_text), "%.35s%s",
-                    books[i]->author, strlen(books[i]->author) > 35 ? "..." : "");
-            GtkWidget *author_label = gtk_label_new(author_text);
-            gtk_label_set_line_wrap(GTK_LABEL(author_label), TRUE);
-            gtk_label_set_max_width_chars(GTK_LABEL(author_label), 20);
-            gtk_widget_set_opacity(author_label, 0.7);
-            gtk_box_pack_start(GTK_BOX(card_box), author_label, FALSE, FALSE, 0);
+/* Same order as db_book_get_all_arena: title (case-insensitive), then id */
+static gint sort_book_cards(GtkFlowBoxChild *a, GtkFlowBoxChild *b, gpointer data) {
+    (void)data;
+    GObject *card_a = G_OBJECT(gtk_bin_get_child(GTK_BIN(a)));
+    GObject *card_b = G_OBJECT(gtk_bin_get_child(GTK_BIN(b)));
+    const char *title_a = g_object_get_data(card_a, "book_title");
+    const char *title_b = g_object_get_data(card_b, "book_title");
+    
+    int cmp = g_ascii_strcasecmp(title_a ? title_a : "", title_b ? title_b : "");
+    if (cmp != 0) return cmp;
+    return GPOINTER_TO_INT(g_object_get_data(card_a, "book_id")) -
+           GPOINTER_TO_INT(g_object_get_data(card_b, "book_id"));
+}
+
+/* Apply a single book change instead of rebuilding the whole grid */
+static void on_db_change(const DbChange *change, void *user_data) {
+    LibraryView *view = (LibraryView *)user_data;
+    if (change->table == DB_TABLE_NOTES) {
+        schedule_badge_refresh(view);
+        return;
+    }
+    
+    // A load in flight may have read the table before this change
+    if (change->kind == DB_CHANGE_RELOAD || view->load_pending) {
+        libraryview_load_books(view);
+        return;
+    }
+    
+    int book_id = (int)change->rowid;
+    GtkWidget *existing = find_flowbox_child(view, "book_id", book_id);
+    int note_count = 0;
+    if (existing) {
+        GtkWidget *old_card = gtk_bin_get_child(GTK_BIN(existing));
+        note_count = GPOINTER_TO_INT(g_object_get_data(G_OBJECT(old_card), "note_count"));
+        gtk_widget_destroy(existing);
+    }
+    
+    Book *book = NULL;
+    if (change->kind != DB_CHANGE_DELETE &&
+        db_book_get_by_id(view->db, book_id, &book) == BN_SUCCESS) {
+        GtkWidget *empty = find_flowbox_child(view, "empty_state", 1);
+        if (empty) {
+            gtk_widget_destroy(empty);
         }
         
-        gtk_container_add(GTK_CONTAINER(card), card_box);
+        GtkWidget *card = create_book_card(view, book, note_count);
         gtk_container_add(GTK_CONTAINER(view->grid), card);
-        
-        book_free(books[i]);
+        gtk_widget_show_all(card);
+        book_free(book);
+        return;
     }
-    free(books);
     
-    gtk_widget_show_all(view->grid);
+    // Deleted (or vanished before we could read it)
+    if (view->selected_book_id == book_id) {
+        view->selected_book_id = -1;
+    }
+    
+    GList *children = gtk_container_get_children(GTK_CONTAINER(view->grid));
+    if (!children) {
+        show_empty_state(view);
+    }
+    g_list_free(children);
 }
 
 void libraryview_set_callback(LibraryView *view,
@@ -702,6 +911,7 @@ void libraryview_set_callback(LibraryView *view,
 
 void libraryview_destroy(LibraryView *view) {
     if (!view) return;
+    db_change_unsubscribe(view->db, on_db_change, view);
     free(view);
 }
 
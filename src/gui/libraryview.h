@@ -3,6 +3,7 @@
 
 #include <gtk/gtk.h>
 #include "../database/db.h"
+#include "dbworker.h"
 
 /**
  * Library view - Grid of books with covers
@@ -17,6 +18,10 @@ typedef struct {
     int selected_book_id;      // Currently selected book id
     
     Database *db;
+    DbWorker *worker;          // Runs the full library load off the main loop
+    guint load_generation;     // Identifies the latest load request
+    gboolean load_pending;     // A load is queued on the worker
+    gboolean badge_refresh_pending; // A note recount is queued on the worker
     
     // Callback when book is selected
     void (*on_book_selected)(int book_id, gpointer user_data);
@@ -26,10 +31,12 @@ typedef struct {
 /**
  * Create library view
  */
-LibraryView* libraryview_create(Database *db);
+LibraryView* libraryview_create(Database *db, DbWorker *worker);
 
 /**
  * Load books into library
+ * The books and their note counts (one GROUP BY query) are read on the
+ * worker; the grid is rebuilt when they arrive.
  */
 void libraryview_load_books(LibraryView *view);
 
@@ -42,11 +49,12 @@ void libraryview_set_callback(LibraryView *view,
 
 /**
  * Show Add Book dialog with ISBN lookup, fetch metadata and cover.
- * On success, inserts book into DB and triggers a refresh via the provided refresh callback.
+ * On success, inserts book into DB and invokes the optional refresh callback.
+ * Views subscribed to the database change feed update themselves.
  *
  * @param parent         Parent GtkWindow for modality
  * @param db             Database handle
- * @param on_refreshed   Callback to invoke after insertion (e.g., libraryview_load_books)
+ * @param on_refreshed   Callback to invoke after insertion, or NULL
  * @param user_data      User data to pass to on_refreshed
  */
 void libraryview_show_add_dialog(GtkWidget *parent,
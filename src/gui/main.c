@@ -53,6 +53,9 @@ int main(int argc, char **argv) {
     
     // Cleanup
     window_destroy(win);
+    if (db->tracing) {
+        db_trace_report(db, stderr);
+    }
     db_close(db);
     
     return 0;
@@ -7,12 +7,14 @@ static void on_note_selected(GtkTreeView *view, gpointer data);
 static void on_save_clicked(GtkWidget *widget, gpointer data);
 static void on_delete_clicked(GtkWidget *widget, gpointer data);
 static void on_new_note_clicked(GtkWidget *widget, gpointer data);
+static void on_db_change(const DbChange *change, void *user_data);
 
-NotesPanel* notespanel_create(Database *db) {
+NotesPanel* notespanel_create(Database *db, DbWorker *worker) {
     NotesPanel *panel = calloc(1, sizeof(NotesPanel));
     if (!panel) return NULL;
     
     panel->db = db;
+    panel->worker = worker;
     panel->current_book_id = -1;
     panel->current_note_id = -1;
     
@@ -109,9 +111,55 @@ NotesPanel* notespanel_create(Database *db) {
     
     gtk_paned_pack2(GTK_PANED(panel->container), bottom_box, TRUE, TRUE);
     
+    // Keep the list in sync with the database
+    db_change_subscribe(panel->db, on_db_change, panel);
+    
     return panel;
 }
 
+static void set_note_row(GtkListStore *store, GtkTreeIter *iter, const Note *note) {
+    char page_str[32];
+    if (note->page_number > 0) {
+        snprintf(page_str, sizeof(page_str), "p.%d", note->page_number);
+    } else {
+        snprintf(page_str, sizeof(page_str), "-");
+    }
+    
+    gtk_list_store_set(store, iter,
+                      NOTE_COL_ID, note->id,
+                      NOTE_COL_TITLE, note->title,
+                      NOTE_COL_PAGE, page_str,
+                      -1);
+}
+
+static gboolean find_note_row(GtkTreeModel *model, int note_id, GtkTreeIter *iter) {
+    gboolean valid = gtk_tree_model_get_iter_first(model, iter);
+    while (valid) {
+        int id;
+        gtk_tree_model_get(model, iter, NOTE_COL_ID, &id, -1);
+        if (id == note_id) {
+            return TRUE;
+        }
+        valid = gtk_tree_model_iter_next(model, iter);
+    }
+    return FALSE;
+}
+
+typedef struct {
+    int book_id;
+    guint generation;
+} NotesLoadTask;
+
+static void on_notes_loaded(BnError err, void *result, void *task, gpointer user_data);
+
+/* Worker thread */
+static BnError load_notes_task(Database *db, void *task, void **out_result) {
+    NoteResultSet *set = NULL;
+    BnError err = db_note_get_by_book_arena(db, ((NotesLoadTask *)task)->book_id, &set);
+    *out_result = set;
+    return err;
+}
+
 void notespanel_load_book(NotesPanel *panel, int book_id) {
     if (!panel || book_id <= 0) return;
     
@@ -127,14 +175,35 @@ void notespanel_load_book(NotesPanel *panel, int book_id) {
     gtk_widget_set_sensitive(panel->save_button, FALSE);
     gtk_widget_set_sensitive(panel->delete_button, FALSE);
     
-    // Load notes
-    Note **notes = NULL;
-    int count = 0;
+    // Don't show the previous book's notes while loading
+    gtk_tree_view_set_model(GTK_TREE_VIEW(panel->notes_list), NULL);
+    
+    NotesLoadTask *task = g_new(NotesLoadTask, 1);
+    task->book_id = book_id;
+    task->generation = ++panel->load_generation;
+    panel->load_pending = TRUE;
+    dbworker_submit_read(panel->worker, load_notes_task, task, g_free, on_notes_loaded,
+                         (GDestroyNotify)db_note_result_free, panel);
+}
+
+static void on_notes_loaded(BnError err, void *result, void *task, gpointer user_data) {
+    NotesPanel *panel = (NotesPanel *)user_data;
+    NoteResultSet *set = (NoteResultSet *)result;
+    
+    // A newer load supersedes this one
+    if (((NotesLoadTask *)task)->generation != panel->load_generation) {
+        db_note_result_free(set);
+        return;
+    }
+    panel->load_pending = FALSE;
     
-    BnError err = db_note_get_by_book(panel->db, book_id, &notes, &count);
     if (err != BN_SUCCESS) {
+        db_note_result_free(set);
         return;
     }
+    int count = set->count;
+    
+    OrgModeEditor *org = (OrgModeEditor *)g_object_get_data(G_OBJECT(panel->editor), "orgmode_editor");
     
     // Create model
     GtkListStore *store = gtk_list_store_new(NOTE_COL_NUM,
@@ -145,23 +214,9 @@ void notespanel_load_book(NotesPanel *panel, int book_id) {
     for (int i = 0; i < count; i++) {
         GtkTreeIter iter;
         gtk_list_store_append(store, &iter);
-        
-        char page_str[32];
-        if (notes[i]->page_number > 0) {
-            snprintf(page_str, sizeof(page_str), "p.%d", notes[i]->page_number);
-        } else {
-            snprintf(page_str, sizeof(page_str), "-");
-        }
-        
-        gtk_list_store_set(store, &iter,
-                          NOTE_COL_ID, notes[i]->id,
-                          NOTE_COL_TITLE, notes[i]->title,
-                          NOTE_COL_PAGE, page_str,
-                          -1);
-        
-        note_free(notes[i]);
+        set_note_row(store, &iter, &set->notes[i]);
     }
-    free(notes);
+    db_note_result_free(set);
     
     gtk_tree_view_set_model(GTK_TREE_VIEW(panel->notes_list), GTK_TREE_MODEL(store));
     g_object_unref(store);
@@ -176,6 +231,8 @@ void notespanel_clear(NotesPanel *panel) {
     
     panel->current_book_id = -1;
     panel->current_note_id = -1;
+    panel->load_generation++;
+    panel->load_pending = FALSE;
     
     // Clear list
     gtk_tree_view_set_model(GTK_TREE_VIEW(panel->notes_list), NULL);
@@ -194,6 +251,7 @@ void notespanel_clear(NotesPanel *panel) {
 
 void notespanel_destroy(NotesPanel *panel) {
     if (!panel) return;
+    db_change_unsubscribe(panel->db, on_db_change, panel);
     // Clear Markdown editor pointer if present
     g_object_set_data(G_OBJECT(panel->editor), "markdown_textview", NULL);
     free(panel);
@@ -216,31 +274,65 @@ static void on_note_selected(GtkTreeView *view, gpointer data) {
     
     panel->current_note_id = note_id;
     
-    // Load note content (we need to get it from DB)
-    Note **notes = NULL;
-    int count = 0;
-    
-    BnError err = db_note_get_by_book(panel->db, panel->current_book_id, &notes, &count);
+    // Load note content
+    Note *note = NULL;
+    BnError err = db_note_get_by_id(panel->db, note_id, &note);
     if (err != BN_SUCCESS) return;
     
-    // Find our note
-    for (int i = 0; i < count; i++) {
-        if (notes[i]->id == note_id) {
-            OrgModeEditor *org = (OrgModeEditor *)g_object_get_data(G_OBJECT(panel->editor), "orgmode_editor");
-            if (org && org->buffer) {
-                gtk_text_buffer_set_text(org->buffer, notes[i]->content, -1);
-                gtk_text_view_set_editable(GTK_TEXT_VIEW(org->text_view), TRUE);
-            }
-            
-            gtk_widget_set_sensitive(panel->save_button, TRUE);
-            gtk_widget_set_sensitive(panel->delete_button, TRUE);
-            
-            note_free(notes[i]);
-            break;
-        }
-        note_free(notes[i]);
+    OrgModeEditor *org = (OrgModeEditor *)g_object_get_data(G_OBJECT(panel->editor), "orgmode_editor");
+    if (org && org->buffer) {
+        gtk_text_buffer_set_text(org->buffer, note->content, -1);
+        gtk_text_view_set_editable(GTK_TEXT_VIEW(org->text_view), TRUE);
+    }
+    
+    gtk_widget_set_sensitive(panel->save_button, TRUE);
+    gtk_widget_set_sensitive(panel->delete_button, TRUE);
+    
+    note_free(note);
+}
+
+typedef struct {
+    int note_id;
+    char *content;
+} NoteSaveTask;
+
+static void free_save_task(gpointer data) {
+    NoteSaveTask *task = (NoteSaveTask *)data;
+    g_free(task->content);
+    g_free(task);
+}
+
+/* Worker thread */
+static BnError save_note_task(Database *db, void *data, void **out_result) {
+    NoteSaveTask *task = (NoteSaveTask *)data;
+    *out_result = NULL;
+    
+    Note *note = NULL;
+    BnError err = db_note_get_by_id(db, task->note_id, &note);
+    if (err != BN_SUCCESS) {
+        return err;
     }
-    free(notes);
+    
+    free(note->content);
+    note->content = g_strdup(task->content);
+    err = note->content ? db_note_update(db, note) : BN_ERROR_OUT_OF_MEMORY;
+    
+    note_free(note);
+    return err;
+}
+
+static void on_note_saved(BnError err, void *result, void *task, gpointer user_data) {
+    (void)result;
+    (void)task;
+    (void)user_data;
+    
+    GtkWidget *dialog = gtk_message_dialog_new(NULL,
+        GTK_DIALOG_MODAL,
+        err == BN_SUCCESS ? GTK_MESSAGE_INFO : GTK_MESSAGE_ERROR,
+        GTK_BUTTONS_OK,
+        err == BN_SUCCESS ? "Note saved successfully!" : "Error saving note");
+    gtk_dialog_run(GTK_DIALOG(dialog));
+    gtk_widget_destroy(dialog);
 }
 
 static void on_save_clicked(GtkWidget *widget, gpointer data) {
@@ -256,54 +348,11 @@ static void on_save_clicked(GtkWidget *widget, gpointer data) {
     gtk_text_buffer_get_bounds(org->buffer, &start, &end);
     char *content = gtk_text_buffer_get_text(org->buffer, &start, &end, FALSE);
     
-    // Load current note to update
-    Note **notes = NULL;
-    int count = 0;
-    BnError err = db_note_get_by_book(panel->db, panel->current_book_id, &notes, &count);
-    
-    if (err != BN_SUCCESS) {
-        g_free(content);
-        return;
-    }
-    
-    // Find and update our note
-    for (int i = 0; i < count; i++) {
-        if (notes[i]->id == panel->current_note_id) {
-            // Update content
-            free(notes[i]->content);
-            notes[i]->content = g_strdup(content);
-            
-            // Save to database
-            err = db_note_update(panel->db, notes[i]);
-            
-            if (err == BN_SUCCESS) {
-                GtkWidget *dialog = gtk_message_dialog_new(NULL,
-                    GTK_DIALOG_MODAL,
-                    GTK_MESSAGE_INFO,
-                    GTK_BUTTONS_OK,
-                    "Note saved successfully!");
-                gtk_dialog_run(GTK_DIALOG(dialog));
-                gtk_widget_destroy(dialog);
-                
-                // Reload notes list
-                notespanel_load_book(panel, panel->current_book_id);
-            } else {
-                GtkWidget *dialog = gtk_message_dialog_new(NULL,
-                    GTK_DIALOG_MODAL,
-                    GTK_MESSAGE_ERROR,
-                    GTK_BUTTONS_OK,
-                    "Error saving note");
-                gtk_dialog_run(GTK_DIALOG(dialog));
-                gtk_widget_destroy(dialog);
-            }
-            
-            note_free(notes[i]);
-            break;
-        }
-        note_free(notes[i]);
-    }
-    free(notes);
-    g_free(content);
+    // Save on the worker (the change feed refreshes the list row)
+    NoteSaveTask *task = g_new(NoteSaveTask, 1);
+    task->note_id = panel->current_note_id;
+    task->content = content;
+    dbworker_submit(panel->worker, save_note_task, task, free_save_task, on_note_saved, NULL, panel);
 }
 
 static void on_delete_clicked(GtkWidget *widget, gpointer data) {
@@ -337,8 +386,7 @@ static void on_delete_clicked(GtkWidget *widget, gpointer data) {
             gtk_widget_set_sensitive(panel->save_button, FALSE);
             gtk_widget_set_sensitive(panel->delete_button, FALSE);
             
-            // Reload list
-            notespanel_load_book(panel, panel->current_book_id);
+            // The change feed removes the list row
         } else {
             GtkWidget *error_dialog = gtk_message_dialog_new(NULL,
                 GTK_DIALOG_MODAL,
@@ -351,6 +399,28 @@ static void on_delete_clicked(GtkWidget *widget, gpointer data) {
     }
 }
 
+/* Worker thread: task is the Note to insert */
+static BnError insert_note_task(Database *db, void *task, void **out_result) {
+    *out_result = NULL;
+    return db_note_insert(db, (Note *)task);
+}
+
+static void on_note_inserted(BnError err, void *result, void *task, gpointer user_data) {
+    (void)result;
+    (void)task;
+    (void)user_data;
+    
+    if (err != BN_SUCCESS) {
+        GtkWidget *error_dialog = gtk_message_dialog_new(NULL,
+            GTK_DIALOG_MODAL,
+            GTK_MESSAGE_ERROR,
+            GTK_BUTTONS_OK,
+            "Error creating note");
+        gtk_dialog_run(GTK_DIALOG(error_dialog));
+        gtk_widget_destroy(error_dialog);
+    }
+}
+
 static void on_new_note_clicked(GtkWidget *widget, gpointer data) {
     (void)widget;
     NotesPanel *panel = (NotesPanel *)data;
@@ -428,21 +498,9 @@ static void on_new_note_clicked(GtkWidget *widget, gpointer data) {
                                  content, page_number);
         
         if (err == BN_SUCCESS) {
-            err = db_note_insert(panel->db, note);
-            
-            if (err == BN_SUCCESS) {
-                notespanel_load_book(panel, panel->current_book_id);
-            } else {
-                GtkWidget *error_dialog = gtk_message_dialog_new(NULL,
-                    GTK_DIALOG_MODAL,
-                    GTK_MESSAGE_ERROR,
-                    GTK_BUTTONS_OK,
-                    "Error creating note");
-                gtk_dialog_run(GTK_DIALOG(error_dialog));
-                gtk_widget_destroy(error_dialog);
-            }
-            
-            note_free(note);
+            // Insert on the worker (the change feed appends the list row)
+            dbworker_submit(panel->worker, insert_note_task, note, (GDestroyNotify)note_free,
+                            on_note_inserted, NULL, panel);
         }
         
         g_free(content);
@@ -450,3 +508,45 @@ static void on_new_note_clicked(GtkWidget *widget, gpointer data) {
     
     gtk_widget_destroy(dialog);
 }
+
+/* Apply a single note change to the list instead of reloading the book */
+static void on_db_change(const DbChange *change, void *user_data) {
+    NotesPanel *panel = (NotesPanel *)user_data;
+    if (panel->current_book_id <= 0 || change->table != DB_TABLE_NOTES) return;
+    
+    // A load in flight may have read the notes before this change
+    if (change->kind == DB_CHANGE_RELOAD || panel->load_pending) {
+        notespanel_load_book(panel, panel->current_book_id);
+        return;
+    }
+    
+    GtkTreeModel *model = gtk_tree_view_get_model(GTK_TREE_VIEW(panel->notes_list));
+    if (!model) return;
+    
+    int note_id = (int)change->rowid;
+    GtkTreeIter iter;
+    gboolean listed = find_note_row(model, note_id, &iter);
+    
+    Note *note = NULL;
+    if (change->kind != DB_CHANGE_DELETE &&
+        db_note_get_by_id(panel->db, note_id, &note) == BN_SUCCESS &&
+        note->book_id == panel->current_book_id) {
+        if (!listed) {
+            gtk_list_store_append(GTK_LIST_STORE(model), &iter);
+        }
+        set_note_row(GTK_LIST_STORE(model), &iter, note);
+        note_free(note);
+        return;
+    }
+    note_free(note);
+    
+    // Deleted, vanished or moved to another book
+    if (listed) {
+        gtk_list_store_remove(GTK_LIST_STORE(model), &iter);
+    }
+    if (panel->current_note_id == note_id) {
+        panel->current_note_id = -1;
+        gtk_widget_set_sensitive(panel->save_button, FALSE);
+        gtk_widget_set_sensitive(panel->delete_button, FALSE);
+    }
+}
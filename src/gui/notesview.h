@@ -5,6 +5,7 @@
 #include "../database/db.h"
 #include "orgmode.h"
 #include "../core/note.h"
+#include "dbworker.h"
 
 /**
  * Notes panel columns
@@ -27,17 +28,21 @@ typedef struct {
     GtkWidget *delete_button;   // Delete button
     
     Database *db;
+    DbWorker *worker;           // Runs list loads and note writes off the main loop
     int current_book_id;
     int current_note_id;        // -1 if no note selected
+    guint load_generation;      // Identifies the latest list load
+    gboolean load_pending;      // A list load is queued on the worker
 } NotesPanel;
 
 /**
  * Create notes panel
  */
-NotesPanel* notespanel_create(Database *db);
+NotesPanel* notespanel_create(Database *db, DbWorker *worker);
 
 /**
  * Load notes for a book
+ * The list is filled when the worker has read the notes.
  */
 void notespanel_load_book(NotesPanel *panel, int book_id);
 
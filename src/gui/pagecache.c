@@ -0,0 +1,123 @@
+#include "pagecache.h"
+#include <stdlib.h>
+
+typedef struct {
+    int page;
+    double zoom;
+    int scale;
+    cairo_surface_t *surface;
+    gsize bytes;
+} PageCacheEntry;
+
+struct PageCache {
+    GQueue lru;                 // PageCacheEntry, most recently used first
+    gsize bytes;
+    gsize budget;
+    guint64 hits;
+    guint64 misses;
+    guint64 evictions;
+};
+
+static void entry_free(PageCacheEntry *entry) {
+    cairo_surface_destroy(entry->surface);
+    g_free(entry);
+}
+
+static gsize surface_bytes(cairo_surface_t *surface) {
+    return (gsize)cairo_image_surface_get_stride(surface) *
+           (gsize)cairo_image_surface_get_height(surface);
+}
+
+/* Drop least recently used surfaces until bytes + incoming fits the budget */
+static void evict(PageCache *cache, gsize incoming) {
+    while (cache->lru.length > 0 && cache->bytes + incoming > cache->budget) {
+        PageCacheEntry *entry = g_queue_pop_tail(&cache->lru);
+        cache->bytes -= entry->bytes;
+        cache->evictions++;
+        entry_free(entry);
+    }
+}
+
+PageCache* pagecache_create(gsize budget) {
+    PageCache *cache = calloc(1, sizeof(PageCache));
+    if (!cache) return NULL;
+
+    g_queue_init(&cache->lru);
+    cache->budget = budget;
+    return cache;
+}
+
+cairo_surface_t* pagecache_lookup(PageCache *cache, int page, double zoom, int scale) {
+    if (!cache) return NULL;
+
+    // A handful of entries at most, so a linear scan beats hashing doubles
+    for (GList *link = cache->lru.head; link; link = link->next) {
+        PageCacheEntry *entry = link->data;
+        if (entry->page == page && entry->zoom == zoom && entry->scale == scale) {
+            if (link != cache->lru.head) {
+                g_queue_unlink(&cache->lru, link);
+                g_queue_push_head_link(&cache->lru, link);
+            }
+            cache->hits++;
+            return entry->surface;
+        }
+    }
+
+    cache->misses++;
+    return NULL;
+}
+
+gboolean pagecache_insert(PageCache *cache, int page, double zoom, int scale,
+                          cairo_surface_t *surface) {
+    if (!cache || !surface) return FALSE;
+
+    gsize bytes = surface_bytes(surface);
+    if (bytes > cache->budget) return FALSE;
+
+    evict(cache, bytes);
+
+    PageCacheEntry *entry = g_new(PageCacheEntry, 1);
+    entry->page = page;
+    entry->zoom = zoom;
+    entry->scale = scale;
+    entry->surface = cairo_surface_reference(surface);
+    entry->bytes = bytes;
+    g_queue_push_head(&cache->lru, entry);
+    cache->bytes += bytes;
+    return TRUE;
+}
+
+void pagecache_clear(PageCache *cache) {
+    if (!cache) return;
+
+    g_queue_clear_full(&cache->lru, (GDestroyNotify)entry_free);
+    cache->bytes = 0;
+}
+
+void pagecache_set_budget(PageCache *cache, gsize budget) {
+    if (!cache) return;
+
+    cache->budget = budget;
+    evict(cache, 0);
+}
+
+void pagecache_get_stats(const PageCache *cache, PageCacheStats *stats) {
+    if (!stats) return;
+
+    *stats = (PageCacheStats){0};
+    if (!cache) return;
+
+    stats->hits = cache->hits;
+    stats->misses = cache->misses;
+    stats->evictions = cache->evictions;
+    stats->bytes = cache->bytes;
+    stats->budget = cache->budget;
+    stats->entries = cache->lru.length;
+}
+
+void pagecache_destroy(PageCache *cache) {
+    if (!cache) return;
+
+    pagecache_clear(cache);
+    free(cache);
+}
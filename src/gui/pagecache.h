@@ -0,0 +1,69 @@
+#ifndef BOOKNOTE_PAGECACHE_H
+#define BOOKNOTE_PAGECACHE_H
+
+#include <gtk/gtk.h>
+
+/**
+ * Rendered page cache
+ *
+ * Keeps rasterized pages as cairo image surfaces, keyed by page number,
+ * zoom level and device scale, so redraws blit instead of re-rendering the
+ * page. Surfaces are evicted least recently used first once their total
+ * size exceeds the memory budget. Main loop only.
+ */
+typedef struct PageCache PageCache;
+
+/**
+ * Counters for tuning the budget
+ */
+typedef struct {
+    guint64 hits;               // Lookups served from the cache
+    guint64 misses;             // Lookups that had to render
+    guint64 evictions;          // Surfaces dropped to stay within budget
+    gsize bytes;                // Pixel memory held now
+    gsize budget;               // Limit for bytes
+    guint entries;              // Surfaces held now
+} PageCacheStats;
+
+/**
+ * Create a cache holding at most budget bytes of pixel data
+ */
+PageCache* pagecache_create(gsize budget);
+
+/**
+ * Find a rendered page
+ *
+ * @return Surface owned by the cache (valid until the next insert, clear
+ *         or budget change), or NULL on a miss
+ */
+cairo_surface_t* pagecache_lookup(PageCache *cache, int page, double zoom, int scale);
+
+/**
+ * Add a rendered page, evicting older ones as needed
+ * Takes a reference to surface. Returns FALSE when the surface alone is
+ * larger than the budget and was not kept.
+ */
+gboolean pagecache_insert(PageCache *cache, int page, double zoom, int scale,
+                          cairo_surface_t *surface);
+
+/**
+ * Drop every surface (the counters are kept)
+ */
+void pagecache_clear(PageCache *cache);
+
+/**
+ * Change the budget, evicting down to it
+ */
+void pagecache_set_budget(PageCache *cache, gsize budget);
+
+/**
+ * Read the counters
+ */
+void pagecache_get_stats(const PageCache *cache, PageCacheStats *stats);
+
+/**
+ * Free the cache and its surfaces
+ */
+void pagecache_destroy(PageCache *cache);
+
+#endif // BOOKNOTE_PAGECACHE_H
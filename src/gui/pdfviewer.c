@@ -1,12 +1,33 @@
 #include "pdfviewer.h"
+#include <math.h>
 #include <stdlib.h>
 #include <string.h>
 
+// Default memory budget of the rendered page cache, overridden in MiB by
+// BOOKNOTE_PAGE_CACHE_MB. A fit-width page is 2-5 MiB, four times that on HiDPI.
+#define PAGE_CACHE_BUDGET (64 * 1024 * 1024)
+
+// Scan progress reaches the main loop at most this often (and with the first hit)
+#define FIND_FLUSH_US (100 * 1000)
+
+/* One find match; rect is in points with the origin at the top left */
+typedef struct {
+    int page;
+    int order;                  // Position on its page, for a stable sort
+    PopplerRectangle rect;
+} PdfFindMatch;
+
 static void render_page(PDFViewer *viewer);
 static gboolean on_draw(GtkWidget *widget, cairo_t *cr, gpointer data);
 static void on_prev_clicked(GtkWidget *widget, gpointer data);
 static void on_next_clicked(GtkWidget *widget, gpointer data);
 static void update_controls(PDFViewer *viewer);
+static GtkWidget* create_find_bar(PDFViewer *viewer);
+static void find_reset(PDFViewer *viewer);
+static void find_start(PDFViewer *viewer, const char *text);
+static void update_find_status(PDFViewer *viewer);
+static void draw_find_matches(PDFViewer *viewer, cairo_t *cr);
+static void log_cache_stats(PDFViewer *viewer);
 
 PDFViewer* pdfviewer_create(void) {
     PDFViewer *viewer = calloc(1, sizeof(PDFViewer));
@@ -18,10 +39,24 @@ PDFViewer* pdfviewer_create(void) {
     viewer->document = NULL;
     viewer->current_page = NULL;
     viewer->current_filepath = NULL;
+    viewer->find_matches = g_array_new(FALSE, FALSE, sizeof(PdfFindMatch));
+    viewer->find_current = -1;
+    
+    gsize budget = PAGE_CACHE_BUDGET;
+    const char *budget_mb = g_getenv("BOOKNOTE_PAGE_CACHE_MB");
+    if (budget_mb && *budget_mb) {
+        budget = (gsize)g_ascii_strtoull(budget_mb, NULL, 10) * 1024 * 1024;
+    }
+    viewer->page_cache = pagecache_create(budget);
     
     // Main container
     viewer->container = gtk_box_new(GTK_ORIENTATION_VERTICAL, 0);
     
+    // Find bar above the page
+    viewer->find_bar = create_find_bar(viewer);
+    gtk_box_pack_start(GTK_BOX(viewer->container), viewer->find_bar, FALSE, FALSE, 0);
+    gtk_widget_set_no_show_all(viewer->find_bar, TRUE);
+    
     // Drawing area for PDF rendering
     viewer->drawing_area = gtk_drawing_area_new();
     gtk_widget_set_size_request(viewer->drawing_area, 600, 800);
@@ -34,6 +69,7 @@ PDFViewer* pdfviewer_create(void) {
                                    GTK_POLICY_AUTOMATIC);
     gtk_container_add(GTK_CONTAINER(scrolled), viewer->drawing_area);
     gtk_box_pack_start(GTK_BOX(viewer->container), scrolled, TRUE, TRUE, 0);
+    viewer->scrolled = scrolled;
     
     // Navigation controls
     GtkWidget *nav_box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 5);
@@ -87,9 +123,31 @@ PDFViewer* pdfviewer_create(void) {
     return viewer;
 }
 
+/* File URI for poppler; relative paths are taken from the working directory */
+static char* build_uri(const char *filepath) {
+    if (g_path_is_absolute(filepath)) {
+        return g_filename_to_uri(filepath, NULL, NULL);
+    }
+    
+    char *cwd = g_get_current_dir();
+    char *absolute = g_build_filename(cwd, filepath, NULL);
+    char *uri = g_filename_to_uri(absolute, NULL, NULL);
+    g_free(absolute);
+    g_free(cwd);
+    return uri;
+}
+
 gboolean pdfviewer_load_file(PDFViewer *viewer, const char *filepath) {
     if (!viewer || !filepath) return FALSE;
     
+    // Matches belong to the previous document
+    find_reset(viewer);
+    update_find_status(viewer);
+    
+    // Pages are cached by number, so they go with the document
+    log_cache_stats(viewer);
+    pagecache_clear(viewer->page_cache);
+    
     // Close previous document
     if (viewer->current_page) {
         g_object_unref(viewer->current_page);
@@ -103,15 +161,7 @@ gboolean pdfviewer_load_file(PDFViewer *viewer, const char *filepath) {
     viewer->current_filepath = NULL;
     
     // Build file URI
-    char *uri;
-    if (g_path_is_absolute(filepath)) {
-        uri = g_filename_to_uri(filepath, NULL, NULL);
-    } else {
-        char *absolute = g_build_filename(g_get_current_dir(), filepath, NULL);
-        uri = g_filename_to_uri(absolute, NULL, NULL);
-        g_free(absolute);
-    }
-    
+    char *uri = build_uri(filepath);
     if (!uri) return FALSE;
     
     // Load document
@@ -145,12 +195,23 @@ gboolean pdfviewer_load_file(PDFViewer *viewer, const char *filepath) {
     pdfviewer_zoom_fit_width(viewer);
     render_page(viewer);
     
+    // An open find bar searches the new document too
+    if (gtk_widget_get_visible(viewer->find_bar)) {
+        find_start(viewer, gtk_entry_get_text(GTK_ENTRY(viewer->find_entry)));
+    }
+    
     return TRUE;
 }
 
 void pdfviewer_clear(PDFViewer *viewer) {
     if (!viewer) return;
     
+    find_reset(viewer);
+    update_find_status(viewer);
+    
+    log_cache_stats(viewer);
+    pagecache_clear(viewer->page_cache);
+    
     if (viewer->current_page) {
         g_object_unref(viewer->current_page);
         viewer->current_page = NULL;
@@ -261,6 +322,13 @@ void pdfviewer_zoom_fit_width(PDFViewer *viewer) {
 void pdfviewer_destroy(PDFViewer *viewer) {
     if (!viewer) return;
     
+    // A scan still running finishes on its own without touching the viewer
+    find_reset(viewer);
+    g_array_free(viewer->find_matches, TRUE);
+    
+    log_cache_stats(viewer);
+    pagecache_destroy(viewer->page_cache);
+    
     if (viewer->current_page) {
         g_object_unref(viewer->current_page);
     }
@@ -271,6 +339,74 @@ void pdfviewer_destroy(PDFViewer *viewer) {
     free(viewer);
 }
 
+void pdfviewer_set_cache_budget(PDFViewer *viewer, gsize budget) {
+    if (!viewer) return;
+    pagecache_set_budget(viewer->page_cache, budget);
+}
+
+void pdfviewer_get_cache_stats(PDFViewer *viewer, PageCacheStats *stats) {
+    pagecache_get_stats(viewer ? viewer->page_cache : NULL, stats);
+}
+
+/* Summary for tuning, shown with G_MESSAGES_DEBUG=all */
+static void log_cache_stats(PDFViewer *viewer) {
+    PageCacheStats stats;
+    pagecache_get_stats(viewer->page_cache, &stats);
+    
+    guint64 lookups = stats.hits + stats.misses;
+    if (lookups == 0) return;
+    
+    g_debug("Page cache: %.1f%% hits (%" G_GUINT64_FORMAT " / %" G_GUINT64_FORMAT "), "
+            "%" G_GUINT64_FORMAT " evictions, %u pages in %.1f / %.1f MiB",
+            100.0 * (double)stats.hits / (double)lookups, stats.hits, lookups,
+            stats.evictions, stats.entries,
+            stats.bytes / (1024.0 * 1024.0), stats.budget / (1024.0 * 1024.0));
+}
+
+/*
+ * Rasterize the current page at the current zoom and device scale
+ * Returns a new reference, or NULL if the surface could not be created.
+ */
+static cairo_surface_t* render_page_surface(PDFViewer *viewer, int scale) {
+    double page_width, page_height;
+    poppler_page_get_size(viewer->current_page, &page_width, &page_height);
+    
+    int width = (int)ceil(page_width * viewer->zoom_level * scale);
+    int height = (int)ceil(page_height * viewer->zoom_level * scale);
+    
+    // Pages are opaque, so no alpha channel
+    cairo_surface_t *surface = cairo_image_surface_create(CAIRO_FORMAT_RGB24, width, height);
+    if (cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS) {
+        cairo_surface_destroy(surface);
+        return NULL;
+    }
+    cairo_surface_set_device_scale(surface, scale, scale);
+    
+    cairo_t *cr = cairo_create(surface);
+    cairo_set_source_rgb(cr, 1.0, 1.0, 1.0);
+    cairo_paint(cr);
+    cairo_scale(cr, viewer->zoom_level, viewer->zoom_level);
+    poppler_page_render(viewer->current_page, cr);
+    cairo_destroy(cr);
+    
+    return surface;
+}
+
+/* Cached render of the current page (new reference), rendering on a miss */
+static cairo_surface_t* get_page_surface(PDFViewer *viewer, int scale) {
+    cairo_surface_t *surface = pagecache_lookup(viewer->page_cache, viewer->current_page_num,
+                                                viewer->zoom_level, scale);
+    if (surface) return cairo_surface_reference(surface);
+    
+    surface = render_page_surface(viewer, scale);
+    if (surface) {
+        // Too large for the budget is fine, it is drawn once and dropped
+        pagecache_insert(viewer->page_cache, viewer->current_page_num,
+                         viewer->zoom_level, scale, surface);
+    }
+    return surface;
+}
+
 static void render_page(PDFViewer *viewer) {
     if (!viewer || !viewer->current_page) return;
     
@@ -320,9 +456,9 @@ static gboolean on_draw(GtkWidget *widget, cairo_t *cr, gpointer data) {
     double scaled_width = page_width * viewer->zoom_level;
     double scaled_height = page_height * viewer->zoom_level;
     
-    // Center the PDF
-    double x_offset = (alloc.width - scaled_width) / 2.0;
-    double y_offset = (alloc.height - scaled_height) / 2.0;
+    // Center the PDF, on whole pixels so the cached page blits unfiltered
+    double x_offset = floor((alloc.width - scaled_width) / 2.0);
+    double y_offset = floor((alloc.height - scaled_height) / 2.0);
     
     // Ensure non-negative offsets
     if (x_offset < 0) x_offset = 0;
@@ -350,9 +486,21 @@ static gboolean on_draw(GtkWidget *widget, cairo_t *cr, gpointer data) {
     cairo_rectangle(cr, 0, 0, scaled_width, scaled_height);
     cairo_fill(cr);
     
-    // Scale for zoom and render
-    cairo_scale(cr, viewer->zoom_level, viewer->zoom_level);
-    poppler_page_render(viewer->current_page, cr);
+    // Blit the cached render, only re-rasterizing on a miss
+    cairo_surface_t *surface = get_page_surface(viewer, gtk_widget_get_scale_factor(widget));
+    if (surface) {
+        cairo_set_source_surface(cr, surface, 0, 0);
+        cairo_rectangle(cr, 0, 0, scaled_width, scaled_height);
+        cairo_fill(cr);
+        cairo_surface_destroy(surface);
+        cairo_scale(cr, viewer->zoom_level, viewer->zoom_level);
+    } else {
+        cairo_scale(cr, viewer->zoom_level, viewer->zoom_level);
+        poppler_page_render(viewer->current_page, cr);
+    }
+    
+    // Find matches, in page coordinates like the render
+    draw_find_matches(viewer, cr);
     
     return TRUE;
 }
@@ -381,3 +529,358 @@ static void update_controls(PDFViewer *viewer) {
     gtk_widget_set_sensitive(viewer->next_button, 
                             viewer->current_page_num < viewer->total_pages - 1);
 }
+
+/* ============================================================================
+ * Find in document
+ *
+ * Poppler documents are not safe to share between threads, so the scan
+ * opens its own copy of the file. It walks the pages from the current one
+ * (wrapping at the end) and posts batches of matches to the main loop,
+ * where they are merged into find_matches in document order.
+ * ========================================================================= */
+
+struct PdfFindJob {
+    gint ref_count;
+    gint cancelled;             // Set on the main loop, polled by the scan
+    char *uri;
+    char *text;
+    int start_page;
+    int page_count;
+    PDFViewer *viewer;          // Only used on the main loop while not cancelled
+    int pages_delivered;        // Pages scanned as of the last batch (main loop)
+};
+
+typedef struct {
+    PdfFindJob *job;
+    GArray *matches;            // PdfFindMatch found since the previous batch
+    int scanned;                // Pages scanned so far
+    gboolean finished;
+} PdfFindBatch;
+
+static PdfFindJob* find_job_ref(PdfFindJob *job) {
+    g_atomic_int_inc(&job->ref_count);
+    return job;
+}
+
+static void find_job_unref(PdfFindJob *job) {
+    if (g_atomic_int_dec_and_test(&job->ref_count)) {
+        g_free(job->uri);
+        g_free(job->text);
+        g_free(job);
+    }
+}
+
+static void update_find_status(PDFViewer *viewer) {
+    char status[128];
+    guint count = viewer->find_matches->len;
+    PdfFindJob *job = viewer->find_job;
+    
+    if (viewer->find_current >= 0 && job) {
+        snprintf(status, sizeof(status), "Match %d of %u (searching, %d / %d pages)",
+                 viewer->find_current + 1, count, job->pages_delivered, job->page_count);
+    } else if (viewer->find_current >= 0) {
+        snprintf(status, sizeof(status), "Match %d of %u", viewer->find_current + 1, count);
+    } else if (job) {
+        snprintf(status, sizeof(status), "Searching... %d / %d pages",
+                 job->pages_delivered, job->page_count);
+    } else if (count == 0 && gtk_entry_get_text_length(GTK_ENTRY(viewer->find_entry)) > 0) {
+        snprintf(status, sizeof(status), "No matches");
+    } else {
+        status[0] = '\0';
+    }
+    gtk_label_set_text(GTK_LABEL(viewer->find_status), status);
+}
+
+static gint compare_matches(gconstpointer a, gconstpointer b) {
+    const PdfFindMatch *ma = (const PdfFindMatch *)a;
+    const PdfFindMatch *mb = (const PdfFindMatch *)b;
+    if (ma->page != mb->page) return ma->page < mb->page ? -1 : 1;
+    return ma->order < mb->order ? -1 : ma->order > mb->order;
+}
+
+/* Index of the first match on page or after it */
+static guint first_match_from(PDFViewer *viewer, int page) {
+    guint lo = 0;
+    guint hi = viewer->find_matches->len;
+    while (lo < hi) {
+        guint mid = lo + (hi - lo) / 2;
+        if (g_array_index(viewer->find_matches, PdfFindMatch, mid).page < page) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+/* Show the selected match: its page, scrolled so the rectangle is visible */
+static void show_current_match(PDFViewer *viewer) {
+    if (viewer->find_current < 0) return;
+    
+    const PdfFindMatch *match = &g_array_index(viewer->find_matches, PdfFindMatch, viewer->find_current);
+    if (match->page != viewer->current_page_num) {
+        pdfviewer_goto_page(viewer, match->page);
+    }
+    
+    GtkAdjustment *vadj = gtk_scrolled_window_get_vadjustment(GTK_SCROLLED_WINDOW(viewer->scrolled));
+    GtkAdjustment *hadj = gtk_scrolled_window_get_hadjustment(GTK_SCROLLED_WINDOW(viewer->scrolled));
+    gtk_adjustment_clamp_page(vadj, match->rect.y1 * viewer->zoom_level,
+                              match->rect.y2 * viewer->zoom_level);
+    gtk_adjustment_clamp_page(hadj, match->rect.x1 * viewer->zoom_level,
+                              match->rect.x2 * viewer->zoom_level);
+    
+    gtk_widget_queue_draw(viewer->drawing_area);
+}
+
+/* Merge a batch of matches into find_matches */
+static void merge_find_batch(PDFViewer *viewer, PdfFindJob *job, const PdfFindBatch *batch) {
+    if (batch->matches->len > 0) {
+        // Keep the selection on the same match across the re-sort
+        PdfFindMatch selected = { 0 };
+        gboolean had_selection = viewer->find_current >= 0;
+        if (had_selection) {
+            selected = g_array_index(viewer->find_matches, PdfFindMatch, viewer->find_current);
+        }
+        
+        g_array_append_vals(viewer->find_matches, batch->matches->data, batch->matches->len);
+        g_array_sort(viewer->find_matches, compare_matches);
+        
+        if (had_selection) {
+            guint index = 0;
+            g_array_binary_search(viewer->find_matches, &selected, compare_matches, &index);
+            viewer->find_current = (int)index;
+        } else {
+            // First hits: jump to the first one from where the search started
+            guint index = first_match_from(viewer, job->start_page);
+            viewer->find_current = index < viewer->find_matches->len ? (int)index : 0;
+            show_current_match(viewer);
+        }
+        
+        // Highlights may have arrived for the page on screen
+        gtk_widget_queue_draw(viewer->drawing_area);
+    }
+    
+    job->pages_delivered = batch->scanned;
+    if (batch->finished) {
+        viewer->find_job = NULL;
+        find_job_unref(job);        // The viewer's reference
+    }
+    update_find_status(viewer);
+}
+
+/* Main loop */
+static gboolean deliver_find_batch(gpointer data) {
+    PdfFindBatch *batch = (PdfFindBatch *)data;
+    PdfFindJob *job = batch->job;
+    
+    // Skipped if the search was replaced or the viewer is gone
+    if (!g_atomic_int_get(&job->cancelled)) {
+        merge_find_batch(job->viewer, job, batch);
+    }
+    
+    g_array_free(batch->matches, TRUE);
+    find_job_unref(job);            // The batch's reference
+    g_free(batch);
+    return G_SOURCE_REMOVE;
+}
+
+static void post_find_batch(PdfFindJob *job, GArray *matches, int scanned, gboolean finished) {
+    PdfFindBatch *batch = g_new(PdfFindBatch, 1);
+    batch->job = find_job_ref(job);
+    batch->matches = matches;
+    batch->scanned = scanned;
+    batch->finished = finished;
+    g_idle_add(deliver_find_batch, batch);
+}
+
+/* Scan thread */
+static gpointer find_thread(gpointer data) {
+    PdfFindJob *job = (PdfFindJob *)data;
+    GArray *matches = g_array_new(FALSE, FALSE, sizeof(PdfFindMatch));
+    int scanned = 0;
+    gboolean posted_hit = FALSE;
+    gint64 last_flush = g_get_monotonic_time();
+    
+    PopplerDocument *doc = poppler_document_new_from_file(job->uri, NULL, NULL);
+    
+    for (int i = 0; doc && i < job->page_count && !g_atomic_int_get(&job->cancelled); i++) {
+        int page_num = (job->start_page + i) % job->page_count;
+        PopplerPage *page = poppler_document_get_page(doc, page_num);
+        if (page) {
+            double width, height;
+            poppler_page_get_size(page, &width, &height);
+            
+            GList *rects = poppler_page_find_text(page, job->text);
+            int order = 0;
+            for (GList *l = rects; l; l = l->next) {
+                PopplerRectangle *r = (PopplerRectangle *)l->data;
+                // Poppler measures y from the bottom of the page
+                PdfFindMatch match = { page_num, order++, { r->x1, height - r->y2, r->x2, height - r->y1 } };
+                g_array_append_val(matches, match);
+                poppler_rectangle_free(r);
+            }
+            g_list_free(rects);
+            g_object_unref(page);
+        }
+        scanned++;
+        
+        // The first hit goes out at once; the rest in timed batches
+        gint64 now = g_get_monotonic_time();
+        if ((matches->len > 0 && !posted_hit) || now - last_flush >= FIND_FLUSH_US) {
+            posted_hit = posted_hit || matches->len > 0;
+            post_find_batch(job, matches, scanned, FALSE);
+            matches = g_array_new(FALSE, FALSE, sizeof(PdfFindMatch));
+            last_flush = now;
+        }
+    }
+    
+    if (doc) g_object_unref(doc);
+    post_find_batch(job, matches, scanned, TRUE);
+    find_job_unref(job);            // The thread's reference
+    return NULL;
+}
+
+/* Cancel the scan and forget the matches */
+static void find_reset(PDFViewer *viewer) {
+    if (viewer->find_job) {
+        g_atomic_int_set(&viewer->find_job->cancelled, 1);
+        find_job_unref(viewer->find_job);
+        viewer->find_job = NULL;
+    }
+    g_array_set_size(viewer->find_matches, 0);
+    viewer->find_current = -1;
+}
+
+static void find_start(PDFViewer *viewer, const char *text) {
+    find_reset(viewer);
+    gtk_widget_queue_draw(viewer->drawing_area);
+    if (!viewer->document || !viewer->current_filepath || !text || !*text) {
+        update_find_status(viewer);
+        return;
+    }
+    
+    PdfFindJob *job = g_new0(PdfFindJob, 1);
+    job->ref_count = 2;             // The viewer and the thread
+    job->uri = build_uri(viewer->current_filepath);
+    job->text = g_strdup(text);
+    job->start_page = viewer->current_page_num;
+    job->page_count = viewer->total_pages;
+    job->viewer = viewer;
+    viewer->find_job = job;
+    
+    update_find_status(viewer);
+    g_thread_unref(g_thread_new("pdf-find", find_thread, job));
+}
+
+static void draw_find_matches(PDFViewer *viewer, cairo_t *cr) {
+    guint len = viewer->find_matches->len;
+    for (guint i = first_match_from(viewer, viewer->current_page_num); i < len; i++) {
+        const PdfFindMatch *match = &g_array_index(viewer->find_matches, PdfFindMatch, i);
+        if (match->page != viewer->current_page_num) break;
+        
+        if ((int)i == viewer->find_current) {
+            cairo_set_source_rgba(cr, 1.0, 0.5, 0.0, 0.5);
+        } else {
+            cairo_set_source_rgba(cr, 1.0, 0.85, 0.0, 0.35);
+        }
+        cairo_rectangle(cr, match->rect.x1, match->rect.y1,
+                        match->rect.x2 - match->rect.x1, match->rect.y2 - match->rect.y1);
+        cairo_fill(cr);
+    }
+}
+
+/* Step through the matches; with none selected, start from the current page */
+static void find_step(PDFViewer *viewer, int direction) {
+    int len = (int)viewer->find_matches->len;
+    if (len == 0) return;
+    
+    if (viewer->find_current < 0) {
+        int first = (int)first_match_from(viewer, viewer->current_page_num);
+        viewer->find_current = direction > 0 ? first % len : (first - 1 + len) % len;
+    } else {
+        viewer->find_current = (viewer->find_current + direction + len) % len;
+    }
+    
+    show_current_match(viewer);
+    update_find_status(viewer);
+}
+
+void pdfviewer_find_next(PDFViewer *viewer) {
+    if (!viewer) return;
+    find_step(viewer, 1);
+}
+
+void pdfviewer_find_prev(PDFViewer *viewer) {
+    if (!viewer) return;
+    find_step(viewer, -1);
+}
+
+void pdfviewer_find_show(PDFViewer *viewer) {
+    if (!viewer) return;
+    gtk_widget_show(viewer->find_bar);
+    gtk_widget_grab_focus(viewer->find_entry);
+}
+
+void pdfviewer_find_hide(PDFViewer *viewer) {
+    if (!viewer) return;
+    find_reset(viewer);
+    gtk_entry_set_text(GTK_ENTRY(viewer->find_entry), "");
+    update_find_status(viewer);
+    gtk_widget_hide(viewer->find_bar);
+    gtk_widget_queue_draw(viewer->drawing_area);
+}
+
+static void on_find_changed(GtkSearchEntry *entry, gpointer data) {
+    find_start((PDFViewer *)data, gtk_entry_get_text(GTK_ENTRY(entry)));
+}
+
+static gboolean on_find_key_press(GtkWidget *widget, GdkEventKey *event, gpointer data) {
+    (void)widget;
+    PDFViewer *viewer = (PDFViewer *)data;
+    
+    // Enter: next match, Shift+Enter: previous
+    if (event->keyval == GDK_KEY_Return || event->keyval == GDK_KEY_KP_Enter) {
+        find_step(viewer, (event->state & GDK_SHIFT_MASK) ? -1 : 1);
+        return TRUE;
+    }
+    return FALSE;
+}
+
+static GtkWidget* create_find_bar(PDFViewer *viewer) {
+    GtkWidget *bar = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 5);
+    gtk_widget_set_name(bar, "find-bar");
+    gtk_widget_set_margin_start(bar, 5);
+    gtk_widget_set_margin_end(bar, 5);
+    gtk_widget_set_margin_top(bar, 5);
+    gtk_widget_set_margin_bottom(bar, 5);
+    
+    viewer->find_entry = gtk_search_entry_new();
+    gtk_entry_set_placeholder_text(GTK_ENTRY(viewer->find_entry), "Find in document");
+    g_signal_connect(viewer->find_entry, "search-changed", G_CALLBACK(on_find_changed), viewer);
+    g_signal_connect(viewer->find_entry, "key-press-event", G_CALLBACK(on_find_key_press), viewer);
+    g_signal_connect_swapped(viewer->find_entry, "next-match", G_CALLBACK(pdfviewer_find_next), viewer);
+    g_signal_connect_swapped(viewer->find_entry, "previous-match", G_CALLBACK(pdfviewer_find_prev), viewer);
+    g_signal_connect_swapped(viewer->find_entry, "stop-search", G_CALLBACK(pdfviewer_find_hide), viewer);
+    gtk_box_pack_start(GTK_BOX(bar), viewer->find_entry, FALSE, FALSE, 0);
+    
+    GtkWidget *prev = gtk_button_new_with_label("▲");
+    g_signal_connect_swapped(prev, "clicked", G_CALLBACK(pdfviewer_find_prev), viewer);
+    gtk_box_pack_start(GTK_BOX(bar), prev, FALSE, FALSE, 0);
+    
+    GtkWidget *next = gtk_button_new_with_label("▼");
+    g_signal_connect_swapped(next, "clicked", G_CALLBACK(pdfviewer_find_next), viewer);
+    gtk_box_pack_start(GTK_BOX(bar), next, FALSE, FALSE, 0);
+    
+    viewer->find_status = gtk_label_new("");
+    gtk_widget_set_halign(viewer->find_status, GTK_ALIGN_START);
+    gtk_box_pack_start(GTK_BOX(bar), viewer->find_status, TRUE, TRUE, 5);
+    
+    GtkWidget *close = gtk_button_new_with_label("✕");
+    g_signal_connect_swapped(close, "clicked", G_CALLBACK(pdfviewer_find_hide), viewer);
+    gtk_box_pack_end(GTK_BOX(bar), close, FALSE, FALSE, 0);
+    
+    // Children are shown now; the bar itself stays hidden until Ctrl+F
+    gtk_widget_show_all(bar);
+    gtk_widget_hide(bar);
+    return bar;
+}
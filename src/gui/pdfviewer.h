@@ -3,6 +3,12 @@
 
 #include <gtk/gtk.h>
 #include <poppler.h>
+#include "pagecache.h"
+
+/**
+ * Background text search over the loaded document (see pdfviewer.c)
+ */
+typedef struct PdfFindJob PdfFindJob;
 
 /**
  * PDF Viewer widget structure
@@ -14,6 +20,15 @@ typedef struct {
     GtkWidget *prev_button;     // Previous page
     GtkWidget *next_button;     // Next page
     GtkWidget *zoom_label;      // "100%"
+    GtkWidget *scrolled;        // Scrolled window around the drawing area
+    
+    // Find bar (hidden until pdfviewer_find_show)
+    GtkWidget *find_bar;
+    GtkWidget *find_entry;
+    GtkWidget *find_status;     // "Match 3 of 41" or scan progress
+    PdfFindJob *find_job;       // Scan in progress, NULL when idle
+    GArray *find_matches;       // Matches found so far, in document order
+    int find_current;           // Index of the selected match, -1 for none
     
     PopplerDocument *document;  // Current PDF document
     PopplerPage *current_page;  // Current page
@@ -21,6 +36,7 @@ typedef struct {
     int current_page_num;       // Current page number (0-indexed)
     int total_pages;            // Total pages in document
     double zoom_level;          // Zoom level (1.0 = 100%)
+    PageCache *page_cache;      // Rendered pages, blitted by on_draw
     
     char *current_filepath;     // Path to current PDF
 } PDFViewer;
@@ -47,6 +63,16 @@ void pdfviewer_goto_page(PDFViewer *viewer, int page_num);
 void pdfviewer_next_page(PDFViewer *viewer);
 void pdfviewer_prev_page(PDFViewer *viewer);
 
+/**
+ * Find in document
+ * Matches are searched page by page on a background thread, starting at
+ * the current page, and highlighted as they arrive.
+ */
+void pdfviewer_find_show(PDFViewer *viewer);
+void pdfviewer_find_hide(PDFViewer *viewer);
+void pdfviewer_find_next(PDFViewer *viewer);
+void pdfviewer_find_prev(PDFViewer *viewer);
+
 /**
  * Zoom controls
  */
@@ -55,6 +81,14 @@ void pdfviewer_zoom_out(PDFViewer *viewer);
 void pdfviewer_zoom_fit(PDFViewer *viewer);
 void pdfviewer_zoom_fit_width(PDFViewer *viewer);
 
+/**
+ * Rendered page cache
+ * The budget is in bytes of pixel data; the stats report hit rate and
+ * memory use for tuning it.
+ */
+void pdfviewer_set_cache_budget(PDFViewer *viewer, gsize budget);
+void pdfviewer_get_cache_stats(PDFViewer *viewer, PageCacheStats *stats);
+
 /**
  * Destroy viewer
  */
@@ -0,0 +1,284 @@
+#include "searchview.h"
+#include "../database/queries.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define SEARCH_LIMIT 50
+#define RESULTS_WIDTH 520
+#define RESULTS_HEIGHT 420
+
+// Snippet markers, replaced by <b></b> once the text is escaped
+#define MARK_OPEN "\x02"
+#define MARK_CLOSE "\x03"
+
+typedef struct {
+    char *query;                // FTS5 query built from the entry text
+    guint generation;
+} SearchTask;
+
+typedef struct {
+    LibraryHitKind kind;
+    int book_id;
+    int page_number;
+    char *book_title;
+    char *title;                // Note title, NULL for page hits
+    char *snippet;
+} SearchRow;
+
+static void search_task_free(gpointer data) {
+    SearchTask *task = (SearchTask *)data;
+    free(task->query);
+    g_free(task);
+}
+
+static void search_row_free(gpointer data) {
+    SearchRow *row = (SearchRow *)data;
+    g_free(row->book_title);
+    g_free(row->title);
+    g_free(row->snippet);
+    g_free(row);
+}
+
+/* Worker thread: copy the hits, which are only valid until the next step */
+static BnError search_task(Database *db, void *task, void **out_result) {
+    SearchOptions opts;
+    db_search_options_init(&opts);
+    opts.limit = SEARCH_LIMIT;
+    opts.mark_open = MARK_OPEN;
+    opts.mark_close = MARK_CLOSE;
+
+    LibrarySearchCursor *cursor = NULL;
+    BnError err = db_library_search(db, ((SearchTask *)task)->query, &opts, &cursor);
+    if (err != BN_SUCCESS) return err;
+
+    GPtrArray *rows = g_ptr_array_new_with_free_func(search_row_free);
+    const LibraryHit *hit = NULL;
+    while ((err = db_library_search_next(cursor, &hit)) == BN_SUCCESS && hit) {
+        SearchRow *row = g_new0(SearchRow, 1);
+        row->kind = hit->kind;
+        row->book_id = hit->book_id;
+        row->page_number = hit->page_number;
+        row->book_title = g_strdup(hit->book_title);
+        row->title = g_strdup(hit->title);
+        row->snippet = g_strdup(hit->snippet);
+        g_ptr_array_add(rows, row);
+    }
+    db_library_search_close(cursor);
+
+    *out_result = rows;
+    return err;
+}
+
+/* Pango markup for a snippet: escaped text with the matches in bold */
+static char* snippet_markup(const char *snippet) {
+    GString *markup = g_string_new(NULL);
+    const char *p = snippet ? snippet : "";
+
+    while (*p) {
+        size_t len = strcspn(p, MARK_OPEN MARK_CLOSE);
+        gchar *escaped = g_markup_escape_text(p, (gssize)len);
+        g_string_append(markup, escaped);
+        g_free(escaped);
+        p += len;
+
+        if (*p == MARK_OPEN[0]) {
+            g_string_append(markup, "<b>");
+            p++;
+        } else if (*p == MARK_CLOSE[0]) {
+            g_string_append(markup, "</b>");
+            p++;
+        }
+    }
+
+    return g_string_free(markup, FALSE);
+}
+
+static GtkWidget* create_hit_row(const SearchRow *row) {
+    GtkWidget *box = gtk_box_new(GTK_ORIENTATION_VERTICAL, 2);
+    gtk_widget_set_margin_start(box, 8);
+    gtk_widget_set_margin_end(box, 8);
+    gtk_widget_set_margin_top(box, 6);
+    gtk_widget_set_margin_bottom(box, 6);
+
+    // "Book - page 12 - note: Title" or "Book - page 12 - PDF text"
+    GString *meta = g_string_new(row->book_title ? row->book_title : "");
+    if (row->page_number > 0) {
+        g_string_append_printf(meta, " - page %d", row->page_number);
+    }
+    if (row->kind == LIBRARY_HIT_NOTE) {
+        g_string_append_printf(meta, " - note: %s", row->title ? row->title : "");
+    } else {
+        g_string_append(meta, " - PDF text");
+    }
+
+    GtkWidget *meta_label = gtk_label_new(meta->str);
+    gtk_widget_set_name(meta_label, "search-hit-meta");
+    gtk_label_set_ellipsize(GTK_LABEL(meta_label), PANGO_ELLIPSIZE_END);
+    gtk_widget_set_halign(meta_label, GTK_ALIGN_START);
+    gtk_box_pack_start(GTK_BOX(box), meta_label, FALSE, FALSE, 0);
+    g_string_free(meta, TRUE);
+
+    char *markup = snippet_markup(row->snippet);
+    GtkWidget *snippet_label = gtk_label_new(NULL);
+    gtk_label_set_markup(GTK_LABEL(snippet_label), markup);
+    gtk_label_set_line_wrap(GTK_LABEL(snippet_label), TRUE);
+    gtk_label_set_xalign(GTK_LABEL(snippet_label), 0.0);
+    gtk_box_pack_start(GTK_BOX(box), snippet_label, FALSE, FALSE, 0);
+    g_free(markup);
+
+    GtkWidget *list_row = gtk_list_box_row_new();
+    gtk_container_add(GTK_CONTAINER(list_row), box);
+    g_object_set_data(G_OBJECT(list_row), "book_id", GINT_TO_POINTER(row->book_id));
+    g_object_set_data(G_OBJECT(list_row), "page_number", GINT_TO_POINTER(row->page_number));
+    return list_row;
+}
+
+static void clear_results(SearchView *view) {
+    GList *children = gtk_container_get_children(GTK_CONTAINER(view->results));
+    for (GList *l = children; l; l = l->next) {
+        gtk_widget_destroy(GTK_WIDGET(l->data));
+    }
+    g_list_free(children);
+}
+
+static void on_search_done(BnError err, void *result, void *task, gpointer user_data) {
+    SearchView *view = (SearchView *)user_data;
+    GPtrArray *rows = (GPtrArray *)result;
+
+    // Typing has moved on; a newer search is queued
+    if (((SearchTask *)task)->generation != view->search_generation) {
+        if (rows) g_ptr_array_unref(rows);
+        return;
+    }
+
+    clear_results(view);
+    if (err != BN_SUCCESS) {
+        gtk_label_set_text(GTK_LABEL(view->status), bn_error_string(err));
+    } else if (rows->len == 0) {
+        gtk_label_set_text(GTK_LABEL(view->status), "No matches in notes or indexed PDFs");
+    } else {
+        char status[64];
+        snprintf(status, sizeof(status), rows->len == SEARCH_LIMIT ? "Best %u matches" : "%u match(es)",
+                 rows->len);
+        gtk_label_set_text(GTK_LABEL(view->status), status);
+
+        for (guint i = 0; i < rows->len; i++) {
+            gtk_container_add(GTK_CONTAINER(view->results), create_hit_row(g_ptr_array_index(rows, i)));
+        }
+    }
+    if (rows) g_ptr_array_unref(rows);
+
+    gtk_widget_show_all(view->popover);
+    gtk_popover_popup(GTK_POPOVER(view->popover));
+}
+
+static void on_search_changed(GtkSearchEntry *entry, gpointer data) {
+    SearchView *view = (SearchView *)data;
+
+    // Also drops the completion of a search still running
+    view->search_generation++;
+
+    // The last word is a prefix, for search-as-you-type
+    char *query = NULL;
+    if (db_fts_word_query(gtk_entry_get_text(GTK_ENTRY(entry)), DB_FTS_PREFIX_LAST | DB_FTS_OPERATORS,
+                          &query) != BN_SUCCESS) {
+        gtk_popover_popdown(GTK_POPOVER(view->popover));
+        clear_results(view);
+        return;
+    }
+
+    SearchTask *task = g_new(SearchTask, 1);
+    task->query = query;
+    task->generation = view->search_generation;
+    dbworker_submit_read(view->worker, search_task, task, search_task_free, on_search_done,
+                         (GDestroyNotify)g_ptr_array_unref, view);
+}
+
+static void on_row_activated(GtkListBox *box, GtkListBoxRow *row, gpointer data) {
+    (void)box;
+    SearchView *view = (SearchView *)data;
+
+    int book_id = GPOINTER_TO_INT(g_object_get_data(G_OBJECT(row), "book_id"));
+    int page_number = GPOINTER_TO_INT(g_object_get_data(G_OBJECT(row), "page_number"));
+
+    gtk_popover_popdown(GTK_POPOVER(view->popover));
+    if (view->on_hit_activated && book_id > 0) {
+        view->on_hit_activated(book_id, page_number, view->user_data);
+    }
+}
+
+/* Enter opens the best hit */
+static void on_entry_activate(GtkEntry *entry, gpointer data) {
+    (void)entry;
+    SearchView *view = (SearchView *)data;
+
+    GtkListBoxRow *first = gtk_list_box_get_row_at_index(GTK_LIST_BOX(view->results), 0);
+    if (first) {
+        on_row_activated(GTK_LIST_BOX(view->results), first, view);
+    }
+}
+
+static void on_stop_search(GtkSearchEntry *entry, gpointer data) {
+    (void)entry;
+    SearchView *view = (SearchView *)data;
+    gtk_popover_popdown(GTK_POPOVER(view->popover));
+}
+
+SearchView* searchview_create(DbWorker *worker) {
+    SearchView *view = calloc(1, sizeof(SearchView));
+    if (!view) return NULL;
+
+    view->worker = worker;
+
+    view->entry = gtk_search_entry_new();
+    gtk_widget_set_name(view->entry, "library-search");
+    gtk_entry_set_placeholder_text(GTK_ENTRY(view->entry), "Search notes and books (Ctrl+K)");
+    g_signal_connect(view->entry, "search-changed", G_CALLBACK(on_search_changed), view);
+    g_signal_connect(view->entry, "activate", G_CALLBACK(on_entry_activate), view);
+    g_signal_connect(view->entry, "stop-search", G_CALLBACK(on_stop_search), view);
+
+    // Not modal, so typing continues in the entry while results are shown
+    view->popover = gtk_popover_new(view->entry);
+    gtk_popover_set_modal(GTK_POPOVER(view->popover), FALSE);
+    gtk_popover_set_position(GTK_POPOVER(view->popover), GTK_POS_BOTTOM);
+
+    GtkWidget *vbox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 4);
+    gtk_container_set_border_width(GTK_CONTAINER(vbox), 6);
+
+    view->status = gtk_label_new(NULL);
+    gtk_widget_set_halign(view->status, GTK_ALIGN_START);
+    gtk_box_pack_start(GTK_BOX(vbox), view->status, FALSE, FALSE, 0);
+
+    GtkWidget *scrolled = gtk_scrolled_window_new(NULL, NULL);
+    gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(scrolled),
+                                   GTK_POLICY_NEVER, GTK_POLICY_AUTOMATIC);
+    gtk_widget_set_size_request(scrolled, RESULTS_WIDTH, RESULTS_HEIGHT);
+
+    view->results = gtk_list_box_new();
+    gtk_list_box_set_activate_on_single_click(GTK_LIST_BOX(view->results), TRUE);
+    g_signal_connect(view->results, "row-activated", G_CALLBACK(on_row_activated), view);
+    gtk_container_add(GTK_CONTAINER(scrolled), view->results);
+    gtk_box_pack_start(GTK_BOX(vbox), scrolled, TRUE, TRUE, 0);
+
+    gtk_container_add(GTK_CONTAINER(view->popover), vbox);
+
+    return view;
+}
+
+void searchview_set_callback(SearchView *view,
+                             void (*callback)(int book_id, int page_number, gpointer data),
+                             gpointer user_data) {
+    if (!view) return;
+    view->on_hit_activated = callback;
+    view->user_data = user_data;
+}
+
+void searchview_focus(SearchView *view) {
+    if (!view) return;
+    gtk_widget_grab_focus(view->entry);
+}
+
+void searchview_destroy(SearchView *view) {
+    if (!view) return;
+    free(view);
+}
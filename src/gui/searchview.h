@@ -0,0 +1,47 @@
+#ifndef BOOKNOTE_SEARCHVIEW_H
+#define BOOKNOTE_SEARCHVIEW_H
+
+#include <gtk/gtk.h>
+#include "dbworker.h"
+
+/**
+ * Library search - a search entry with a popover of ranked hits from
+ * notes and indexed PDF pages (see db_library_search)
+ */
+typedef struct {
+    GtkWidget *entry;           // GtkSearchEntry, packed by the owner
+    GtkWidget *popover;         // Results below the entry
+    GtkWidget *results;         // GtkListBox of hits
+    GtkWidget *status;          // Hit count or error
+
+    DbWorker *worker;           // Runs the searches off the main loop
+    guint search_generation;    // Identifies the latest search
+
+    // Callback when a hit is activated (page_number is 1-based, 0 if none)
+    void (*on_hit_activated)(int book_id, int page_number, gpointer user_data);
+    gpointer user_data;
+} SearchView;
+
+/**
+ * Create search view
+ */
+SearchView* searchview_create(DbWorker *worker);
+
+/**
+ * Set callback for hit activation
+ */
+void searchview_set_callback(SearchView *view,
+                             void (*callback)(int book_id, int page_number, gpointer data),
+                             gpointer user_data);
+
+/**
+ * Move keyboard focus to the search entry
+ */
+void searchview_focus(SearchView *view);
+
+/**
+ * Destroy search view
+ */
+void searchview_destroy(SearchView *view);
+
+#endif // BOOKNOTE_SEARCHVIEW_H
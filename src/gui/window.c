@@ -8,6 +8,7 @@
 #define DEFAULT_WIDTH 1200
 #define DEFAULT_HEIGHT 800
 #define NOTES_WIDTH 400
+#define CHANGE_POLL_SECONDS 2
 
 static void on_destroy(GtkWidget *widget, gpointer data) {
     (void)widget;
@@ -32,6 +33,16 @@ static gboolean on_key_press(GtkWidget *widget, GdkEventKey *event, gpointer dat
             case GDK_KEY_l:
                 window_show_library(win);
                 return TRUE;
+            case GDK_KEY_k:
+                searchview_focus(win->search_view);
+                return TRUE;
+            case GDK_KEY_f:
+                // Find in the open document
+                if (g_strcmp0(gtk_stack_get_visible_child_name(GTK_STACK(win->stack)), "reading") == 0) {
+                    pdfviewer_find_show(win->pdf_viewer);
+                    return TRUE;
+                }
+                break;
         }
     }
 
@@ -47,11 +58,32 @@ static void on_library_book_selected(int book_id, gpointer user_data) {
     window_show_reading(win, book_id);
 }
 
+static void on_search_hit_activated(int book_id, int page_number, gpointer user_data) {
+    MainWindow *win = (MainWindow *)user_data;
+
+    // Keep the open document when the hit is in the book being read
+    const char *visible = gtk_stack_get_visible_child_name(GTK_STACK(win->stack));
+    if (book_id != win->current_book_id || g_strcmp0(visible, "reading") != 0) {
+        window_show_reading(win, book_id);
+    }
+    if (page_number > 0) {
+        pdfviewer_goto_page(win->pdf_viewer, page_number - 1);
+    }
+}
+
 static void on_add_book_clicked(GtkWidget *widget, gpointer data) {
     (void)widget;
     MainWindow *win = (MainWindow *)data;
 
-    libraryview_show_add_dialog(win->window, win->db, (void (*)(void *))libraryview_load_books, win->library_view);
+    // The library view picks up the new book from the change feed
+    libraryview_show_add_dialog(win->window, win->db, NULL, NULL);
+}
+
+static gboolean on_poll_changes(gpointer data) {
+    MainWindow *win = (MainWindow *)data;
+    // Edits made by the CLI (or another window) arrive as reload events
+    db_change_poll(win->db, NULL);
+    return G_SOURCE_CONTINUE;
 }
 
 static void on_back_clicked(GtkWidget *button, gpointer data) {
@@ -156,7 +188,7 @@ static GtkWidget* create_reading_view(MainWindow *win) {
     win->pdf_viewer = pdfviewer_create();
     gtk_paned_pack1(GTK_PANED(content_paned), win->pdf_viewer->container, TRUE, TRUE);
 
-    win->notes_panel = notespanel_create(win->db);
+    win->notes_panel = notespanel_create(win->db, win->worker);
     win->notes_container = win->notes_panel->container;
     gtk_paned_pack2(GTK_PANED(content_paned), win->notes_panel->container, FALSE, TRUE);
 
@@ -175,6 +207,7 @@ MainWindow* window_create(Database *db) {
     win->db = db;
     win->notes_visible = TRUE;
     win->current_book_id = -1;
+    win->worker = dbworker_create(db);
 
     // Main window
     win->window = gtk_window_new(GTK_WINDOW_TOPLEVEL);
@@ -188,8 +221,16 @@ MainWindow* window_create(Database *db) {
     GtkWidget *main_vbox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 0);
     gtk_container_add(GTK_CONTAINER(win->window), main_vbox);
 
+    // Menu bar with the search entry at its right
+    GtkWidget *top_bar = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 0);
     GtkWidget *menu_bar = create_menu_bar(win);
-    gtk_box_pack_start(GTK_BOX(main_vbox), menu_bar, FALSE, FALSE, 0);
+    gtk_box_pack_start(GTK_BOX(top_bar), menu_bar, TRUE, TRUE, 0);
+
+    win->search_view = searchview_create(win->worker);
+    searchview_set_callback(win->search_view, on_search_hit_activated, win);
+    gtk_widget_set_margin_end(win->search_view->entry, 8);
+    gtk_box_pack_end(GTK_BOX(top_bar), win->search_view->entry, FALSE, FALSE, 0);
+    gtk_box_pack_start(GTK_BOX(main_vbox), top_bar, FALSE, FALSE, 0);
 
     // GtkStack for navigation
     win->stack = gtk_stack_new();
@@ -198,7 +239,7 @@ MainWindow* window_create(Database *db) {
     gtk_box_pack_start(GTK_BOX(main_vbox), win->stack, TRUE, TRUE, 0);
 
     // Library view
-    win->library_view = libraryview_create(db);
+    win->library_view = libraryview_create(db, win->worker);
     libraryview_set_callback(win->library_view, on_library_book_selected, win);
     gtk_widget_set_name(win->library_view->add_button, "add-book-button");
     g_signal_connect(win->library_view->add_button, "clicked", G_CALLBACK(on_add_book_clicked), win);
@@ -214,11 +255,18 @@ MainWindow* window_create(Database *db) {
     libraryview_load_books(win->library_view);
     gtk_stack_set_visible_child_name(GTK_STACK(win->stack), "library");
 
+    win->change_poll_id = g_timeout_add_seconds(CHANGE_POLL_SECONDS, on_poll_changes, win);
+
     return win;
 }
 
 void window_destroy(MainWindow *win) {
     if (!win) return;
+    if (win->change_poll_id) {
+        g_source_remove(win->change_poll_id);
+    }
+    dbworker_destroy(win->worker);
+    searchview_destroy(win->search_view);
     free(win);
 }
 
@@ -237,7 +285,6 @@ void window_toggle_notes(MainWindow *win) {
 void window_show_library(MainWindow *win) {
     if (!win) return;
     gtk_stack_set_visible_child_name(GTK_STACK(win->stack), "library");
-    libraryview_load_books(win->library_view);
 }
 
 void window_show_reading(MainWindow *win, int book_id) {
@@ -5,6 +5,8 @@
 #include "notesview.h"
 #include "pdfviewer.h"
 #include "libraryview.h"
+#include "searchview.h"
+#include "dbworker.h"
 #include "../database/db.h"
 
 /**
@@ -38,13 +40,18 @@ typedef struct {
     // Library view widget
     LibraryView *library_view;
 
+    // Search over notes and PDF text (in the menu bar row)
+    SearchView *search_view;
+
     // State
     Database *db;
+    DbWorker *worker;                // Background connection for slow queries and writes
     gboolean notes_visible;
 
     // Current state
     int current_book_id;
     gboolean sidebar_visible;
+    guint change_poll_id;            // Timer checking for changes from other processes
 } MainWindow;
 
 /**
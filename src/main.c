@@ -13,6 +13,18 @@ int main(int argc, char **argv) {
         return 1;
     }
     
+    // Global option: print per-statement query statistics at exit
+    int trace_queries = 0;
+    if (strcmp(argv[1], "--trace-queries") == 0) {
+        trace_queries = 1;
+        argv++;
+        argc--;
+        if (argc < 2) {
+            cmd_help(0, NULL);
+            return 1;
+        }
+    }
+    
     char *command = argv[1];
     
     // Commands that don't need database
@@ -32,6 +44,10 @@ int main(int argc, char **argv) {
         return 1;
     }
     
+    if (trace_queries && !db->tracing) {
+        db_trace_enable(db, -1);
+    }
+    
     // Route to command
     int result = 0;
     
@@ -45,14 +61,33 @@ int main(int argc, char **argv) {
         result = cmd_note(db, argc, argv);
     } else if (strcmp(command, "search") == 0) {
         result = cmd_search(db, argc, argv);
+    } else if (strcmp(command, "find") == 0) {
+        result = cmd_find(db, argc, argv);
     } else if (strcmp(command, "delete") == 0) {
         result = cmd_delete(db, argc, argv);
+    } else if (strcmp(command, "reindex") == 0) {
+        result = cmd_reindex(db, argc, argv);
+    } else if (strcmp(command, "import-notes") == 0) {
+        result = cmd_import_notes(db, argc, argv);
+    } else if (strcmp(command, "index-pdf") == 0) {
+        result = cmd_index_pdf(db, argc, argv);
+    } else if (strcmp(command, "stats") == 0) {
+        result = cmd_stats(db, argc, argv);
+    } else if (strcmp(command, "backup") == 0) {
+        result = cmd_backup(db, argc, argv);
+    } else if (strcmp(command, "restore") == 0) {
+        result = cmd_restore(db, argc, argv);
     } else {
         fprintf(stderr, "Error: Unknown command '%s'\n", command);
         fprintf(stderr, "Run 'booknote help' for usage information.\n");
         result = 1;
     }
     
+    // Tracing is on via --trace-queries or BOOKNOTE_TRACE_QUERIES
+    if (db->tracing) {
+        db_trace_report(db, stderr);
+    }
+    
     db_close(db);
     return result;
 }
@@ -0,0 +1,93 @@
+#include "arena.h"
+#include <stdalign.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct ArenaBlock {
+    ArenaBlock *next;
+    size_t size;
+    size_t used;
+    alignas(max_align_t) unsigned char data[];
+};
+
+#define ARENA_ALIGN (alignof(max_align_t))
+
+static size_t align_up(size_t n) {
+    return (n + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+}
+
+void arena_init(Arena *arena, size_t block_size) {
+    if (!arena) {
+        return;
+    }
+    
+    memset(arena, 0, sizeof(Arena));
+    arena->block_size = block_size ? block_size : ARENA_DEFAULT_BLOCK_SIZE;
+}
+
+void* arena_alloc(Arena *arena, size_t size) {
+    if (!arena) {
+        return NULL;
+    }
+    
+    size = align_up(size ? size : 1);
+    
+    ArenaBlock *block = arena->head;
+    if (!block || block->size - block->used < size) {
+        size_t block_size = size > arena->block_size ? size : arena->block_size;
+        
+        ArenaBlock *fresh = malloc(sizeof(ArenaBlock) + block_size);
+        if (!fresh) {
+            return NULL;
+        }
+        fresh->size = block_size;
+        fresh->used = 0;
+        
+        if (block && size > arena->block_size) {
+            // Oversized: chain behind the current block so its free space stays usable
+            fresh->next = block->next;
+            block->next = fresh;
+        } else {
+            fresh->next = block;
+            arena->head = fresh;
+        }
+        
+        arena->reserved += block_size;
+        arena->block_count++;
+        block = fresh;
+    }
+    
+    void *ptr = block->data + block->used;
+    block->used += size;
+    arena->used += size;
+    return ptr;
+}
+
+char* arena_strdup(Arena *arena, const char *s) {
+    if (!s) {
+        return NULL;
+    }
+    
+    size_t len = strlen(s) + 1;
+    char *copy = arena_alloc(arena, len);
+    if (copy) {
+        memcpy(copy, s, len);
+    }
+    return copy;
+}
+
+void arena_free(Arena *arena) {
+    if (!arena) {
+        return;
+    }
+    
+    ArenaBlock *block = arena->head;
+    while (block) {
+        ArenaBlock *next = block->next;
+        free(block);
+        block = next;
+    }
+    
+    size_t block_size = arena->block_size;
+    arena_init(arena, block_size);
+}
@@ -0,0 +1,56 @@
+#ifndef BOOKNOTE_ARENA_H
+#define BOOKNOTE_ARENA_H
+
+#include <stddef.h>
+
+/**
+ * Bump allocator
+ * Allocations are carved sequentially out of large blocks and released
+ * all at once with arena_free. Individual allocations cannot be freed.
+ */
+typedef struct ArenaBlock ArenaBlock;
+
+typedef struct {
+    ArenaBlock *head;       // Current block (blocks are chained)
+    size_t block_size;      // Default size for new blocks
+    size_t used;            // Bytes handed out so far
+    size_t reserved;        // Bytes reserved from the system
+    int block_count;        // Number of blocks allocated
+} Arena;
+
+/**
+ * Default block size (64 KiB)
+ */
+#define ARENA_DEFAULT_BLOCK_SIZE (64 * 1024)
+
+/**
+ * Initialize an empty arena
+ * No memory is reserved until the first allocation
+ *
+ * @param arena Arena to initialize
+ * @param block_size Block size in bytes (0 for ARENA_DEFAULT_BLOCK_SIZE)
+ */
+void arena_init(Arena *arena, size_t block_size);
+
+/**
+ * Allocate size bytes, aligned for any type
+ * Requests larger than the block size get a dedicated block
+ *
+ * @return Pointer to uninitialized memory, NULL on allocation failure
+ */
+void* arena_alloc(Arena *arena, size_t size);
+
+/**
+ * Copy a string into the arena
+ *
+ * @return Arena-owned copy, NULL if s is NULL or on allocation failure
+ */
+char* arena_strdup(Arena *arena, const char *s);
+
+/**
+ * Release every block owned by the arena
+ * The arena is left empty and can be reused
+ */
+void arena_free(Arena *arena);
+
+#endif // BOOKNOTE_ARENA_H
@@ -21,6 +21,8 @@ const char* bn_error_string(BnError err) {
             return "Duplicate entry";
         case BN_ERROR_PERMISSION:
             return "Permission denied";
+        case BN_ERROR_BUSY:
+            return "Resource busy";
         case BN_ERROR_UNKNOWN:
         default:
             return "Unknown error";
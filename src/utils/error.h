@@ -14,6 +14,7 @@ typedef enum {
     BN_ERROR_NOT_FOUND,
     BN_ERROR_DUPLICATE,
     BN_ERROR_PERMISSION,
+    BN_ERROR_BUSY,
     BN_ERROR_UNKNOWN
 } BnError;
 
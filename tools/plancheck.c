@@ -0,0 +1,80 @@
+/*
+ * Query plan check (make check)
+ *
+ * Builds the schema in a scratch database and runs EXPLAIN QUERY PLAN on
+ * the listing statements, failing if one stops using its index or sorts
+ * through a temporary B-tree. queries.c is included so the statements
+ * checked are the ones the library prepares.
+ */
+#include "../src/database/queries.c"
+#include <stdio.h>
+
+typedef struct {
+    const char *name;
+    const char *sql;
+    const char *index;          // Must appear in the plan
+} PlanCheck;
+
+/* Plan of sql as one string, detail lines separated by newlines */
+static BnError explain(Database *db, const char *sql, char *out, size_t size) {
+    char query[2048];
+    snprintf(query, sizeof(query), "EXPLAIN QUERY PLAN %s", sql);
+
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(db->handle, query, -1, &stmt, NULL) != SQLITE_OK) {
+        fprintf(stderr, "%s\n", sqlite3_errmsg(db->handle));
+        return BN_ERROR_DATABASE;
+    }
+
+    size_t len = 0;
+    out[0] = '\0';
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        const char *detail = (const char *)sqlite3_column_text(stmt, 3);
+        int written = snprintf(out + len, size - len, "    %s\n", detail ? detail : "");
+        if (written < 0 || (size_t)written >= size - len) break;
+        len += (size_t)written;
+    }
+    sqlite3_finalize(stmt);
+    return BN_SUCCESS;
+}
+
+int main(void) {
+    const PlanCheck checks[] = {
+        { "book list by title", SQL_BOOK_SELECT_ALL, "idx_books_title_nocase" },
+        { "book page by title", SQL_BOOK_PAGE[BOOK_SORT_TITLE][0], "idx_books_title_nocase" },
+        { "book page by title after id", SQL_BOOK_PAGE[BOOK_SORT_TITLE][1], "idx_books_title_nocase" },
+        { "notes of a book", SQL_NOTE_SELECT_BY_BOOK, "idx_notes_book_created" },
+        { "note page by date", SQL_NOTE_PAGE[NOTE_SORT_CREATED][0], "idx_notes_book_created" },
+        { "note page by date after id", SQL_NOTE_PAGE[NOTE_SORT_CREATED][1], "idx_notes_book_created" },
+    };
+
+    DbOptions opts;
+    db_options_init(&opts, DB_PROFILE_FAST);
+    Database *db = NULL;
+    BnError err = db_open_ex(&db, ":memory:", &opts);
+    if (err != BN_SUCCESS) {
+        bn_print_error(err, "opening scratch database");
+        return 1;
+    }
+
+    int failures = 0;
+    for (size_t i = 0; i < sizeof(checks) / sizeof(checks[0]); i++) {
+        char plan[4096];
+        if (explain(db, checks[i].sql, plan, sizeof(plan)) != BN_SUCCESS) {
+            failures++;
+            continue;
+        }
+
+        char index[128];
+        snprintf(index, sizeof(index), "INDEX %s", checks[i].index);
+        int ok = strstr(plan, index) != NULL && strstr(plan, "TEMP B-TREE") == NULL;
+        printf("%s  %s\n", ok ? "ok  " : "FAIL", checks[i].name);
+        if (!ok) {
+            printf("  expected %s and no TEMP B-TREE, got:\n%s", checks[i].index, plan);
+            failures++;
+        }
+    }
+
+    db_close(db);
+    return failures > 0 ? 1 : 0;
+}
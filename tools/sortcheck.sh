@@ -0,0 +1,44 @@
+#!/bin/sh
+#
+# Sort order check (make check)
+#
+# Adds books and notes to a scratch library and checks that `list` and
+# `show` honour --sort, both when walking every row and when paging.
+
+BOOKNOTE="${1:-./booknote}"
+HOME=$(mktemp -d) || exit 1
+export HOME
+trap 'rm -rf "$HOME"' EXIT
+
+failures=0
+
+# expect NAME EXPECTED COMMAND...: the bracketed ids/pages printed, in order
+expect() {
+    name=$1
+    expected=$2
+    shift 2
+    got=$("$@" | sed -n 's/^\[\([0-9]*\)\].*/\1/p' | tr '\n' ' ' | sed 's/ $//')
+    if [ "$got" = "$expected" ]; then
+        echo "ok    $name"
+    else
+        echo "FAIL  $name: expected \"$expected\", got \"$got\""
+        failures=$((failures + 1))
+    fi
+}
+
+"$BOOKNOTE" add /x/z.pdf --title "Zebra" >/dev/null || exit 1
+"$BOOKNOTE" add /x/a.pdf --title "Apple" >/dev/null || exit 1
+"$BOOKNOTE" add /x/m.pdf --title "Mango" >/dev/null || exit 1
+"$BOOKNOTE" note 1 "late page" --page 9 >/dev/null || exit 1
+"$BOOKNOTE" note 1 "early page" --page 2 >/dev/null || exit 1
+"$BOOKNOTE" note 1 "no page" >/dev/null || exit 1
+
+expect "list by title" "2 3 1" "$BOOKNOTE" list
+expect "list by title, paged" "2 3 1" "$BOOKNOTE" list --limit 10
+expect "list --sort added" "1 2 3" "$BOOKNOTE" list --sort added
+expect "list --sort added, paged" "1 2 3" "$BOOKNOTE" list --sort added --limit 10
+expect "show by creation" "1 2 3" "$BOOKNOTE" show 1
+expect "show --sort page" "3 2 1" "$BOOKNOTE" show 1 --sort page
+expect "show --sort page, paged" "3 2 1" "$BOOKNOTE" show 1 --sort page --limit 10
+
+[ "$failures" -eq 0 ]